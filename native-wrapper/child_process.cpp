@@ -0,0 +1,218 @@
+#include "child_process.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+std::wstring quoteArgument(const std::string& arg) {
+    std::wstring quoted = L"\"";
+    for (char c : arg) {
+        if (c == '"') quoted += L'\\';
+        quoted += static_cast<wchar_t>(static_cast<unsigned char>(c));
+    }
+    return quoted + L"\"";
+}
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+// Inheritable pipe handles must not leak into a sibling child started concurrently from another thread
+static std::mutex processCreationMutex;
+
+ChildProcessResult runChildProcess(const std::string& executable, const std::vector<std::string>& args, const std::string& input,
+                                   int timeoutMs) {
+    std::unique_lock<std::mutex> creationLock(processCreationMutex);
+    SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE stdinRead, stdinWrite, stdoutRead, stdoutWrite;
+    if (!CreatePipe(&stdinRead, &stdinWrite, &sa, 0)) {
+        throw std::runtime_error("Failed to create pipes for child process");
+    }
+    if (!CreatePipe(&stdoutRead, &stdoutWrite, &sa, 0)) {
+        CloseHandle(stdinRead);
+        CloseHandle(stdinWrite);
+        throw std::runtime_error("Failed to create pipes for child process");
+    }
+    SetHandleInformation(stdinWrite, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(stdoutRead, HANDLE_FLAG_INHERIT, 0);
+
+    std::wstring commandLine = quoteArgument(executable);
+    for (const std::string& arg : args) {
+        commandLine += L" " + quoteArgument(arg);
+    }
+
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = stdinRead;
+    si.hStdOutput = stdoutWrite;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    PROCESS_INFORMATION pi = {};
+    BOOL started = CreateProcessW(nullptr, &commandLine[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi);
+    CloseHandle(stdinRead);
+    CloseHandle(stdoutWrite);
+    creationLock.unlock();
+    if (!started) {
+        CloseHandle(stdinWrite);
+        CloseHandle(stdoutRead);
+        throw std::runtime_error("Failed to start child process: " + executable);
+    }
+
+    // Feed stdin on a separate thread so a chatty child can never dead-lock on a full stdout pipe
+    std::thread writer([stdinWrite, &input] {
+        DWORD written = 0;
+        WriteFile(stdinWrite, input.data(), static_cast<DWORD>(input.size()), &written, nullptr);
+        CloseHandle(stdinWrite);
+    });
+
+    // Terminating the child closes its end of stdout, which ends the read loop below
+    ChildProcessResult result;
+    std::thread watchdog;
+    if (timeoutMs > 0) {
+        HANDLE process = pi.hProcess;
+        watchdog = std::thread([process, timeoutMs, &result] {
+            if (WaitForSingleObject(process, static_cast<DWORD>(timeoutMs)) == WAIT_TIMEOUT) {
+                TerminateProcess(process, 1);
+                result.timedOut = true;
+            }
+        });
+    }
+
+    char buffer[4096];
+    DWORD bytesRead = 0;
+    while (ReadFile(stdoutRead, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+        result.output.append(buffer, bytesRead);
+    }
+    writer.join();
+    if (watchdog.joinable()) watchdog.join();
+    CloseHandle(stdoutRead);
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    DWORD exitCode = 0;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    result.exitCode = static_cast<int>(exitCode);
+    return result;
+}
+
+std::string currentExecutablePath(const char* argv0) {
+    wchar_t path[MAX_PATH];
+    DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) {
+        return argv0;
+    }
+    int utf8Length = WideCharToMultiByte(CP_UTF8, 0, path, static_cast<int>(length), nullptr, 0, nullptr, nullptr);
+    std::string utf8(utf8Length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, path, static_cast<int>(length), &utf8[0], utf8Length, nullptr, nullptr);
+    return utf8;
+}
+#else
+ChildProcessResult runChildProcess(const std::string& executable, const std::vector<std::string>& args, const std::string& input,
+                                   int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    // O_CLOEXEC: pipes must not leak into sibling children forked concurrently from other threads
+    int stdinPipe[2], stdoutPipe[2];
+    if (pipe2(stdinPipe, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Failed to create pipes for child process");
+    }
+    if (pipe2(stdoutPipe, O_CLOEXEC) != 0) {
+        close(stdinPipe[0]); close(stdinPipe[1]);
+        throw std::runtime_error("Failed to create pipes for child process");
+    }
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(executable.c_str()));
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(stdinPipe[0]); close(stdinPipe[1]);
+        close(stdoutPipe[0]); close(stdoutPipe[1]);
+        throw std::runtime_error("Failed to start child process: " + executable);
+    }
+    if (pid == 0) {
+        dup2(stdinPipe[0], STDIN_FILENO);
+        dup2(stdoutPipe[1], STDOUT_FILENO);
+        close(stdinPipe[0]); close(stdinPipe[1]);
+        close(stdoutPipe[0]); close(stdoutPipe[1]);
+        execv(executable.c_str(), argv.data());
+        _exit(127);
+    }
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
+
+    // Feed stdin on a separate thread so a chatty child can never dead-lock on a full stdout pipe
+    int stdinWrite = stdinPipe[1];
+    std::thread writer([stdinWrite, &input] {
+        size_t offset = 0;
+        while (offset < input.size()) {
+            ssize_t written = write(stdinWrite, input.data() + offset, input.size() - offset);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) break;
+            offset += static_cast<size_t>(written);
+        }
+        close(stdinWrite);
+    });
+
+    ChildProcessResult result;
+    char buffer[4096];
+    ssize_t bytesRead;
+    for (;;) {
+        // ---------- Past the deadline the child is killed; its stdout then reaches EOF ---------- //
+        if (timeoutMs > 0 && !result.timedOut) {
+            auto remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            pollfd readable = { stdoutPipe[0], POLLIN, 0 };
+            int ready = remainingMs > 0 ? poll(&readable, 1, static_cast<int>(remainingMs)) : 0;
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) {
+                kill(pid, SIGKILL);
+                result.timedOut = true;
+            }
+        }
+        bytesRead = read(stdoutPipe[0], buffer, sizeof(buffer));
+        if (bytesRead == 0) break;
+        if (bytesRead < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        result.output.append(buffer, static_cast<size_t>(bytesRead));
+    }
+    writer.join();
+    close(stdoutPipe[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return result;
+}
+
+std::string currentExecutablePath(const char* argv0) {
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) {
+        return argv0;
+    }
+    return std::string(path, static_cast<size_t>(length));
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// ------------------------------ Result of running a child process to completion ------------------------------ //
+struct ChildProcessResult {
+    int exitCode = -1;
+    std::string output;     // stdout as is; for a child wrapper that is its UTF-8 result record
+    bool timedOut = false;  // killed after timeoutMs, output holds what it wrote until then
+};
+
+// ------------------------------ Runs `executable` with `args`, feeds `input` on stdin and collects stdout ------------------------------ //
+// With timeoutMs > 0 a child still running after that long is killed. Throws std::runtime_error if the process
+// cannot be started.
+ChildProcessResult runChildProcess(const std::string& executable, const std::vector<std::string>& args, const std::string& input,
+                                   int timeoutMs = 0);
+
+// ------------------------------ Absolute path of the running wrapper executable ------------------------------ //
+std::string currentExecutablePath(const char* argv0);
@@ -0,0 +1,27 @@
+#include "display_backend.hpp"
+#include "simulator_backend.hpp"
+#include "trace_backend.hpp"
+
+#include <stdexcept>
+
+bool supportsIndependentInstances(const BackendOptions& options) {
+    return options.kind == "simulator";
+}
+
+// ------------------------------ Backend factory ------------------------------ //
+std::unique_ptr<IDisplayBackend> createDisplayBackend(const BackendOptions& options) {
+    std::unique_ptr<IDisplayBackend> backend;
+    if (options.kind == "hdsdk") {
+        backend = loadHdSdkBackend(options.sdkPath);
+    } else if (options.kind == "simulator") {
+        backend = createSimulatorBackend(loadSimulatorConfig(options.simConfigPath));
+    } else {
+        throw std::runtime_error("Unknown display backend: " + options.kind);
+    }
+
+    // ---------- Optional call recording for later replay ---------- //
+    if (!options.recordPath.empty()) {
+        backend = createRecordingBackend(std::move(backend), openTraceFile(options.recordPath));
+    }
+    return backend;
+}
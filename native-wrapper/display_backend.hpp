@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// ------------------------------ Display backend - one screen build + send against some controller SDK ------------------------------ //
+// Every operation mirrors one Hd_* call and keeps the SDK's return conventions:
+//   createScreen / sendScreen / adjustTime  -> 0 on success
+//   addProgram / addArea / addText          -> new ID, or -1 on failure
+// After a failure, lastError() returns the SDK error code (e.g. 13 = timeout).
+class IDisplayBackend {
+public:
+    virtual ~IDisplayBackend() = default;
+
+    // ---------- Short name for logs ("hdsdk", "simulator", ...) ---------- //
+    virtual std::wstring name() const = 0;
+
+    // ---------- Called once per command with its raw payload, before any screen building (decorators record it) ---------- //
+    virtual void beginCommand(const std::string& payload) { (void)payload; }
+
+    // ---------- Screen building ---------- //
+    virtual int createScreen(int width, int height, int cardType) = 0;
+    virtual int addProgram() = 0;
+    virtual int addArea(int programId, int x, int y, int width, int height) = 0;
+    virtual int addText(int areaId, const std::wstring& text, int x, const std::wstring& fontName, int fontHeight) = 0;
+
+    // ---------- Device commands ---------- //
+    virtual int sendScreen(const std::wstring& ipAddress) = 0;
+    virtual bool supportsAdjustTime() const = 0;
+    virtual int adjustTime(const std::wstring& ipAddress) = 0;
+
+    virtual int lastError() = 0;
+};
+
+// ------------------------------ Backend selection (from command line flags) ------------------------------ //
+struct BackendOptions {
+    std::string kind = "hdsdk";   // --backend=<kind>
+    std::string sdkPath;          // --sdk=<path>, empty = platform default library name
+    std::string simConfigPath;    // --sim-config=<file.json>, only for --backend=simulator
+    std::string recordPath;       // --record=<file>, wraps the backend and writes a binary call trace
+};
+
+// ------------------------------ Loads the HDSDK shared library (LoadLibraryW / dlopen) and binds all Hd_* symbols ------------------------------ //
+// Throws std::runtime_error if the library or a required symbol cannot be found.
+std::unique_ptr<IDisplayBackend> loadHdSdkBackend(const std::string& libraryPath);
+
+// ------------------------------ Whether several backend instances can work side by side in one process ------------------------------ //
+// HDSDK keeps a single global screen per process, so parallel work against it needs separate processes.
+bool supportsIndependentInstances(const BackendOptions& options);
+
+// ------------------------------ Creates the backend described by the options ------------------------------ //
+std::unique_ptr<IDisplayBackend> createDisplayBackend(const BackendOptions& options);
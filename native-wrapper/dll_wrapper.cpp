@@ -1,404 +1,677 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <windows.h>
-#include <fcntl.h>
-#include <io.h>
+#include <memory>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include "json.hpp"
+#include "display_backend.hpp"
+#include "trace_backend.hpp"
+#include "payload.hpp"
+#include "send_pipeline.hpp"
+#include "fan_out.hpp"
+#include "fleet.hpp"
+#include "health_cache.hpp"
+#include "child_process.hpp"
+#include "glyph_cache.hpp"
+#include "flight_recorder.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
+#include "perf_trace.hpp"
+#include "result_channel.hpp"
+#include "utf8.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#endif
+
+// ------------------------------ Process-wide options from the command line ------------------------------ //
+struct WrapperOptions {
+    BackendOptions backend;
+    std::string executablePath;
+    ControllerHealthCache* health = nullptr;   // --health-cache=<file.json>, in-memory when no file is given
+    SideBackendFactory sideBackends;           // replay: scripted backends for the fan-out and the time sync (see replayTrace)
+    bool force = false;                        // --force, send even when a sign already shows the content
+    PayloadFormat inputFormat = PayloadFormat::Json;   // --input-format=msgpack, the daemon also switches on "setFormat"
+};
+
+// ------------------------------ Crash result: the flight recorder goes to disk first, then one JSON line ------------------------------ //
+// Runs inside a signal handler or the unhandled exception filter: nothing here may allocate or take a lock (stdio
+// included), so the line is formatted into a stack buffer and written straight to the stdout handle.
+struct CrashLine {
+    char text[512];
+    size_t length = 0;
+
+    void append(const char* part) {
+        while (*part && length < sizeof(text) - 1) text[length++] = *part++;
+    }
 
-using json = nlohmann::json;
-
-// ------------------------------ Maps string-based card types to integer codes ------------------------------ //
-int mapCardType(const std::string& typeStr) {
-    if (typeStr == "E63") return 47;
-    if (typeStr == "E62") return 58;
-    return 0;
+    void append(long long value) {
+        char digits[24];
+        size_t count = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0) append("-");
+        while (count > 0 && length < sizeof(text) - 1) text[length++] = digits[--count];
+    }
+};
+
+void writeCrashResult(const char* error, const char* codeKey, unsigned long code) {
+    recordFlightEvent(FlightEventKind::Crash, codeKey, "", static_cast<int32_t>(code));
+    flushFlightRecorder();
+
+    CrashContext context = findCrashContext();
+    CrashLine line;
+    line.append("{\"success\": false, \"error\": \"");
+    line.append(error);
+    line.append("\", \"");
+    line.append(codeKey);
+    line.append("\": ");
+    line.append(static_cast<long long>(code));
+    if (context.sdkCall) {
+        line.append(", \"sdkCall\": \"");
+        line.append(context.sdkCall);
+        line.append("\", \"sdkArgs\": [");
+        for (int a = 0; a < 4; ++a) {
+            if (a > 0) line.append(", ");
+            line.append(static_cast<long long>(context.args[a]));
+        }
+        line.append("]");
+    }
+    if (context.area >= 0) {
+        line.append(", \"area\": ");
+        line.append(static_cast<long long>(context.area));
+    }
+    if (flightRecorderEnabled()) {
+        line.append(", \"flightRecorder\": ");
+        line.append(flightRecorderPathJson());
+    }
+    line.append("}\n");
+
+#ifdef _WIN32
+    DWORD written = 0;
+    WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), line.text, static_cast<DWORD>(line.length), &written, nullptr);
+#else
+    size_t offset = 0;
+    while (offset < line.length) {
+        ssize_t written = write(STDOUT_FILENO, line.text + offset, line.length - offset);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) break;
+        offset += static_cast<size_t>(written);
+    }
+#endif
 }
 
+#ifdef _WIN32
 // ------------------------------ Catches crashes and prints JSON-formatted error ------------------------------ //
 LONG WINAPI MyUnhandledExceptionFilter(struct _EXCEPTION_POINTERS* ExceptionInfo) {
     DWORD exceptionCode = ExceptionInfo->ExceptionRecord->ExceptionCode;
-    std::wcout << L"{\"success\": false, \"error\": \"CRITICAL_CRASH: Unhandled exception caught!\", \"exception_code\": "
-               << exceptionCode << L"}" << std::endl;
+    writeCrashResult("CRITICAL_CRASH: Unhandled exception caught!", "exception_code", static_cast<unsigned long>(exceptionCode));
     return EXCEPTION_EXECUTE_HANDLER;
 }
+#else
+// ------------------------------ Fatal signals get the same crash result, then the default action (core dump) ------------------------------ //
+void crashSignalHandler(int signalNumber) {
+    writeCrashResult("CRITICAL_CRASH: Fatal signal caught!", "signal", static_cast<unsigned long>(signalNumber));
+    std::raise(signalNumber);   // SA_RESETHAND restored the default action
+}
 
-// ------------------------------ Typedefs for DLL function pointers - loaded dynamically ------------------------------ //
-typedef int (__stdcall *HD_GetSDKLastError)();
-typedef int (__stdcall *HD_CreateScreen)(int, int, int, int, int, void*, int);
-typedef int (__stdcall *HD_AddProgram)(void*, int, int, void*, int);
-typedef int (__stdcall *HD_AddArea)(int, int, int, int, int, void*, int, int, void*, int);
-typedef int (__stdcall *HD_AddSimpleTextAreaItem)(int, void*, int, int, int, void*, int, int, int, int, int, void*, int);
-typedef int (__stdcall *HD_SendScreen)(int, void*, void*, void*, int);
-typedef int (__stdcall *HD_Cmd_AdjustTime)(int, void*, void*);
+void installCrashSignalHandlers() {
+    // A stack overflow leaves no stack for the handler, so it gets its own (worker threads add theirs)
+    prepareCrashHandlerStack();
 
-// ------------------------------ Main Cpp Application ------------------------------ //
-int main() {
-    // ---------- Global handler to catch any unhandled exceptions ---------- //
-    SetUnhandledExceptionFilter(MyUnhandledExceptionFilter);
+    struct sigaction action = {};
+    action.sa_handler = crashSignalHandler;
+    action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    for (int signalNumber : { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT }) {
+        sigaction(signalNumber, &action, nullptr);
+    }
+}
+#endif
 
-    // ---------- Set console output mode to UTF-16, for JSON output ---------- //
-    _setmode(_fileno(stdout), _O_U16TEXT);
+// ------------------------------ Creates the display backend on first use and keeps it for the whole process ------------------------------ //
+IDisplayBackend& ensureBackendLoaded(std::unique_ptr<IDisplayBackend>& backend, const BackendOptions& options) {
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                     DLL INITIALIZATION                             ");
+    WLOG_INFO(L"====================================================================");
 
-    std::wcout << L"\n" << std::endl;
-    std::wcout << L"====================================================================" << std::endl;
-    std::wcout << L"          LED DISPLAY CONTROLLER - C++ WRAPPER v1.0                " << std::endl;
-    std::wcout << L"====================================================================" << std::endl;
+    if (backend) {
+        WLOG_INFO(L"[DLL] [OK] Reusing already loaded backend: " << backend->name());
+        return *backend;
+    }
 
-    // ---------- Read JSON input (piped from electron) ---------- //
-    std::wcout << L"\n[INPUT] Reading JSON payload from stdin..." << std::endl;
-    std::string json_line;
-    std::getline(std::cin, json_line);
-    if (json_line.empty()) {
-        std::wcout << L"[INPUT] [X] ERROR: No JSON input received" << std::endl;
-        std::wcout << L"{\"success\": false, \"error\": \"No JSON input received.\"}" << std::endl;
+    TraceSpan span("loadBackend");
+    backend = createDisplayBackend(options);
+    return *backend;
+}
+
+// ------------------------------ Backend and process details the concurrent paths need ------------------------------ //
+FanOutContext fanOutContext(const WrapperOptions& options) {
+    FanOutContext context;
+    context.backendOptions = options.backend;
+    context.executablePath = options.executablePath;
+    context.health = options.health;
+    context.sideBackends = options.sideBackends;
+    return context;
+}
+
+// ------------------------------ Sends the main display in-process, or fans out when the payload lists several displays ------------------------------ //
+std::vector<DisplayResult> sendToAllDisplays(const Payload& payload, IDisplayBackend& sdk, const WrapperOptions& options) {
+    if (payload.displays.size() == 1) {
+        const DisplayConfig& display = payload.displays[0];
+        ScreenModel model = buildScreenModel(display, payload.fuelItems);
+        DisplayResult result = sendIfChanged(options.health, display.displayIpAddress, screenModelHash(model), payload.force, [&]() {
+            return sendToDisplay(sdk, display, model, payload.retry);
+        });
+        result.fontFit = model.fontFit;
+        return std::vector<DisplayResult>(1, result);
+    }
+
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                  SENDING TO MULTIPLE DISPLAYS                      ");
+    WLOG_INFO(L"====================================================================");
+
+    return sendToDisplaysConcurrently(payload, fanOutContext(options));
+}
+
+// ------------------------------ Time sync only: the command a parent wrapper sends to a child (see TimeSyncTask, runFleet) ------------------------------ //
+int processTimeSyncCommand(const Payload& payload, std::unique_ptr<IDisplayBackend>& backend, const WrapperOptions& options) {
+    try {
+        IDisplayBackend& sdk = ensureBackendLoaded(backend, options.backend);
+        TimeSyncResult result = syncTime(sdk, payload.timeSync, payload.retry);
+        ResultRecord record;
+        record["success"] = result.success;
+        record["adjustTime"] = result.success;
+        record["adjustTimeAttempts"] = result.attempts;
+        record["adjustTimeErrorCode"] = result.errorCode;
+        record["timeSync"] = timeSyncJson(result);
+        writeResult(record);
+        return result.success ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::string err = e.what();
+        writeResult(errorResult(err));
         return 1;
     }
-    std::wcout << L"[INPUT] [OK] JSON received (" << json_line.length() << L" bytes)" << std::endl;
+}
 
-    // ---------- Parse JSON string into structured data ---------- //
-    std::wcout << L"[INPUT] Parsing JSON data..." << std::endl;
-    json data;
+// ------------------------------ Reads one command line into typed structs; prints the JSON error result when it is unusable ------------------------------ //
+bool readCommandLine(const std::string& json_line, PayloadFormat format, PayloadCommand& command) {
+    if (json_line.empty()) {
+        WLOG_ERROR(L"[INPUT] [X] ERROR: No JSON input received");
+        writeResult(errorResult("No JSON input received."));
+        return false;
+    }
+    WLOG_INFO(L"[INPUT] [OK] " << (format == PayloadFormat::MessagePack ? L"MessagePack" : L"JSON")
+              << L" received (" << json_line.length() << L" bytes)");
+
+    // ---------- Stream the command into the payload structs ---------- //
+    WLOG_INFO(L"[INPUT] Parsing JSON data...");
+    TraceSpan span("parse", "wrapper", "bytes", static_cast<int64_t>(json_line.size()));
     try {
-        data = json::parse(json_line);
-        std::wcout << L"[INPUT] [OK] JSON parsed successfully" << std::endl;
-    } catch (json::parse_error& e) {
+        command = readPayloadCommand(json_line, format);
+        span.end();
+        WLOG_INFO(L"[INPUT] [OK] JSON parsed successfully");
+        return true;
+    } catch (const PayloadSyntaxError& e) {
         // If parsing fails, report error details
         std::string err = e.what();
-        std::wcout << L"[INPUT] [X] JSON parse failed: " << std::wstring(err.begin(), err.end()) << std::endl;
-        std::wcout << L"{\"success\": false, \"error\": \"JSON parse error\", \"details\": \""
-                   << std::wstring(err.begin(), err.end()) << L"\"}" << std::endl;
+        WLOG_ERROR(L"[INPUT] [X] JSON parse failed: " << widen(err));
+        ResultRecord record = errorResult("JSON parse error");
+        record["details"] = err;
+        writeResult(record);
+    } catch (const std::exception& e) {
+        std::string err = e.what();
+        WLOG_ERROR(L"[INPUT] [X] Invalid payload: " << widen(err));
+        writeResult(errorResult(err));
+    }
+    return false;
+}
+
+// ------------------------------ Runs one parsed command: build the screen, send it and print one JSON result line ------------------------------ //
+int processCommand(const std::string& json_line, PayloadCommand& command, std::unique_ptr<IDisplayBackend>& backend, const WrapperOptions& options) {
+    recordFlightEvent(FlightEventKind::Phase, "command", command.command.c_str(), static_cast<int32_t>(json_line.size()));
+    if (command.command == "syncTime") {
+        return processTimeSyncCommand(command.payload, backend, options);
+    }
+    if (command.command != "send") {
+        writeResult(errorResult("Unsupported command: " + command.command));
         return 1;
     }
 
-    // ------------------------------ Extract configuration and interact with DLL ------------------------------ //
+    // ------------------------------ Check configuration and interact with DLL ------------------------------ //
+    TraceSpan span("command");
+    auto commandStart = std::chrono::steady_clock::now();
     try {
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                  CONFIGURATION EXTRACTION                          " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-
-        // ---------- Get "config" section from parsed JSON ---------- //
-        auto& config = data["config"];
-        std::wcout << L"[CONFIG] Extracting configuration parameters..." << std::endl;
-
-        // ---------- Extract individual configuration parameters ---------- //
-        std::string ip_address_str = config["displayIpAddress"];
-        std::string cardType_str = config["cardType"];
-        std::string fontName_str = config["fontName"];
-
-        // ---------- Optional parameters with default values ---------- //
-        std::string rowColumn_str = config.value("rowColumn", "R");
-        std::string doubleSided_str = config.value("doubleSided", "N");
-        bool isDoubleSided = (doubleSided_str == "Y" || doubleSided_str == "y");
-        
-        // ---------- Time display parameters ---------- //
-        std::string timeDisplayIpAddress_str = config.value("timeDisplayIpAddress", "");
-        std::string adjustTime_str = config.value("adjustTime", "N");
-
-        // ---------- Screen dimensions and font settings ---------- //
-        int nWidth = config["screenWidth"];
-        int nHeight = config["screenHeight"];
-        int nFontHeight = config["fontHeight"];
-        int nDecimalFontHeight = config.value("decimalFontHeight", nFontHeight);
+        WLOG_INFO(L"\n====================================================================");
+        WLOG_INFO(L"                  CONFIGURATION EXTRACTION                          ");
+        WLOG_INFO(L"====================================================================");
 
-        // ---------- Convert strings to wide strings for DLL function compatibility ---------- //
-        std::wstring ip_address_ws(ip_address_str.begin(), ip_address_str.end());
-        std::wstring fontName_ws(fontName_str.begin(), fontName_str.end());
-        int nCardType = mapCardType(cardType_str);
+        // ---------- "config", "displays" and "fuelItems" were read while parsing ---------- //
+        Payload& payload = command.payload;
+        payload.force = payload.force || options.force;
 
         // ---------- Log parsed configuration details ---------- //
-        std::wcout << L"[CONFIG] [OK] Configuration loaded:" << std::endl;
-        std::wcout << L"         Display IP: " << ip_address_ws << std::endl;
-        std::wcout << L"         Card Type: " << std::wstring(cardType_str.begin(), cardType_str.end()) << L" (Code: " << nCardType << L")" << std::endl;
-        std::wcout << L"         Screen Size: " << nWidth << L"x" << nHeight << L" pixels" << std::endl;
-        std::wcout << L"         Layout: " << std::wstring(rowColumn_str.begin(), rowColumn_str.end()) 
-                   << L" (Double-sided: " << (isDoubleSided ? L"Yes" : L"No") << L")" << std::endl;
-        std::wcout << L"         Font: " << fontName_ws << L" (Height: " << nFontHeight 
-                   << L", Decimal: " << nDecimalFontHeight << L")" << std::endl;
+        WLOG_INFO(L"[CONFIG] [OK] Configuration loaded:");
+        for (const DisplayConfig& display : payload.displays) {
+            WLOG_INFO(L"         Display IP: " << widen(display.displayIpAddress));
+            WLOG_INFO(L"         Card Type: " << widen(display.cardType) << L" (Code: " << mapCardType(display.cardType) << L")");
+            WLOG_INFO(L"         Screen Size: " << display.screenWidth << L"x" << display.screenHeight << L" pixels");
+            WLOG_INFO(L"         Layout: " << widen(display.rowColumn)
+                      << L" (Double-sided: " << (display.doubleSided ? L"Yes" : L"No") << L")");
+            WLOG_INFO(L"         Font: " << widen(display.fontName) << L" (Height: " << display.fontHeight
+                      << L", Decimal: " << display.decimalFontHeight << L")");
+        }
+        const std::string& timeDisplayIpAddress_str = payload.timeSync.timeDisplayIpAddress;
         if (!timeDisplayIpAddress_str.empty()) {
-            std::wcout << L"         Time Display IP: " << std::wstring(timeDisplayIpAddress_str.begin(), timeDisplayIpAddress_str.end()) 
-                       << L" (Adjust: " << std::wstring(adjustTime_str.begin(), adjustTime_str.end()) << L")" << std::endl;
+            WLOG_INFO(L"         Time Display IP: " << widen(timeDisplayIpAddress_str)
+                      << L" (Adjust: " << (payload.timeSync.adjustTime ? L"Y" : L"N") << L")");
         }
 
-        // ---------- Extract array of fuel items ---------- //
-        auto& fuelItems = data["fuelItems"];
-        std::wcout << L"[CONFIG] Fuel items count: " << fuelItems.size() << std::endl;
-        if (fuelItems.empty()) {
+        // ---------- Validate array of fuel items ---------- //
+        WLOG_INFO(L"[CONFIG] Fuel items count: " << payload.fuelItems.size());
+        if (payload.fuelItems.empty()) {
             throw std::runtime_error("FuelItems array is empty.");
         }
-        std::wcout << L"[CONFIG] [OK] All parameters validated" << std::endl;
+        WLOG_INFO(L"[CONFIG] [OK] All parameters validated");
 
-        // ---------- Load the external DLL (HDSdk.dll) ---------- //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                     DLL INITIALIZATION                             " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        
-        std::wcout << L"[DLL] Loading HDSdk.dll..." << std::endl;
-        HINSTANCE hDll = LoadLibraryW(L"HDSdk.dll");
-        if (!hDll) { throw std::runtime_error("Failed to load HDSdk.dll"); }
-        std::wcout << L"[DLL] [OK] HDSdk.dll loaded successfully" << std::endl;
-
-        // ---------- Retrieve function addresses from the DLL ---------- //
-        std::wcout << L"[DLL] Resolving function pointers..." << std::endl;
-        HD_GetSDKLastError Hd_GetSDKLastError_ptr = (HD_GetSDKLastError)GetProcAddress(hDll, "Hd_GetSDKLastError");
-        HD_CreateScreen Hd_CreateScreen_ptr = (HD_CreateScreen)GetProcAddress(hDll, "Hd_CreateScreen");
-        HD_AddProgram Hd_AddProgram_ptr = (HD_AddProgram)GetProcAddress(hDll, "Hd_AddProgram");
-        HD_AddArea Hd_AddArea_ptr = (HD_AddArea)GetProcAddress(hDll, "Hd_AddArea");
-        HD_AddSimpleTextAreaItem Hd_AddSimpleTextAreaItem_ptr = (HD_AddSimpleTextAreaItem)GetProcAddress(hDll, "Hd_AddSimpleTextAreaItem");
-        HD_SendScreen Hd_SendScreen_ptr = (HD_SendScreen)GetProcAddress(hDll, "Hd_SendScreen");
-        HD_Cmd_AdjustTime Cmd_AdjustTime_ptr = (HD_Cmd_AdjustTime)GetProcAddress(hDll, "Cmd_AdjustTime");
-
-        // ---------- Ensure all required functions were found ---------- //
-        if (!Hd_GetSDKLastError_ptr || !Hd_CreateScreen_ptr || !Hd_AddProgram_ptr ||
-            !Hd_AddArea_ptr || !Hd_AddSimpleTextAreaItem_ptr || !Hd_SendScreen_ptr) {
-            throw std::runtime_error("Failed to get one or more required function pointers.");
+        // ---------- Load the display backend (HDSdk.dll) on first use ---------- //
+        IDisplayBackend& sdk = ensureBackendLoaded(backend, options.backend);
+        sdk.beginCommand(json_line);
+
+        // ------------------------------ Synchronize the time display while every display is built and sent ------------------------------ //
+        TimeSyncTask timeSyncTask(payload, fanOutContext(options));
+
+        std::vector<DisplayResult> displayResults = sendToAllDisplays(payload, sdk, options);
+        bool sendScreenSuccess = true;
+        for (const DisplayResult& displayResult : displayResults) {
+            sendScreenSuccess = sendScreenSuccess && displayResult.success;
         }
-        
-        std::wcout << L"[DLL] [OK] Required functions resolved:" << std::endl;
-        std::wcout << L"      - Hd_GetSDKLastError" << std::endl;
-        std::wcout << L"      - Hd_CreateScreen" << std::endl;
-        std::wcout << L"      - Hd_AddProgram" << std::endl;
-        std::wcout << L"      - Hd_AddArea" << std::endl;
-        std::wcout << L"      - Hd_AddSimpleTextAreaItem" << std::endl;
-        std::wcout << L"      - Hd_SendScreen" << std::endl;
-        
-        // ---------- Check optional function pointers ---------- //
-        if (!Cmd_AdjustTime_ptr) {
-            std::wcout << L"[DLL] [!] Optional function Cmd_AdjustTime not available (time adjustment disabled)" << std::endl;
-        } else {
-            std::wcout << L"[DLL] [OK] Optional function Cmd_AdjustTime available" << std::endl;
+
+        TimeSyncResult timeSyncResult = timeSyncTask.wait();
+        bool adjustTimeSuccess = timeSyncResult.success;
+        if (options.health) {
+            TraceSpan saveSpan("healthCacheSave");
+            options.health->save();
         }
 
-        // ---------- Determine total layout size based on orientation and double-sidedness ---------- //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                      LAYOUT CALCULATION                            " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        
-        int totalWidth, totalHeight;
-        std::wcout << L"[LAYOUT] Calculating screen dimensions..." << std::endl;
-        std::wcout << L"[LAYOUT] Base module: " << nWidth << L"x" << nHeight << L" pixels" << std::endl;
-        std::wcout << L"[LAYOUT] Number of fuel items: " << fuelItems.size() << std::endl;
-        std::wcout << L"[LAYOUT] Orientation: " << (rowColumn_str == "C" ? L"Column (vertical)" : L"Row (horizontal)") << std::endl;
+        // ---------- Output final status message in JSON format ---------- //
+        WLOG_INFO(L"\n====================================================================");
+        WLOG_INFO(L"                        FINAL SUMMARY                               ");
+        WLOG_INFO(L"====================================================================");
+        WLOG_INFO(L"  Screen Send:     " << (sendScreenSuccess ? L"[OK] SUCCESS" : L"[X] FAILED"));
+        WLOG_INFO(L"  Time Adjust:     " << (adjustTimeSuccess ? L"[OK] SUCCESS" : L"[X] FAILED"));
+        WLOG_INFO(L"====================================================================\n");
         
-        if (rowColumn_str == "C") {
-            totalWidth = nWidth;
-            totalHeight = nHeight * static_cast<int>(fuelItems.size());
-            if (isDoubleSided) {
-                totalHeight *= 2;
-                std::wcout << L"[LAYOUT] Double-sided enabled - doubling height" << std::endl;
+        // Either half succeeding counts as success; the message says which one failed
+        ResultRecord record;
+        record["success"] = sendScreenSuccess || adjustTimeSuccess;
+        record["message"] = sendScreenSuccess
+            ? (adjustTimeSuccess ? "Screen data sent and time adjusted successfully." : "Screen data sent successfully, but time adjustment failed.")
+            : (adjustTimeSuccess ? "Screen send failed, but time adjustment succeeded." : "Both screen send and time adjustment failed.");
+        record["sendScreen"] = sendScreenSuccess;
+        record["adjustTime"] = adjustTimeSuccess;
+        record["displays"] = displaysJson(displayResults);
+        record["adjustTimeAttempts"] = timeSyncResult.attempts;
+        record["adjustTimeErrorCode"] = timeSyncResult.errorCode;
+        record["timeSync"] = timeSyncJson(timeSyncResult);
+        record["durationMs"] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - commandStart).count();
+        TraceSpan writeSpan("writeResult");
+        writeResult(record);
+
+    } catch (const std::exception& e) {
+        // ---------- Catch and report any exceptions during processing ---------- //
+        std::string err = e.what();
+        writeResult(errorResult(err));
+        return 1;
+    }
+
+    return 0;
+}
+
+// ------------------------------ Processes one JSON payload line ------------------------------ //
+int processPayload(const std::string& json_line, std::unique_ptr<IDisplayBackend>& backend, const WrapperOptions& options) {
+    PayloadCommand command;
+    if (!readCommandLine(json_line, options.inputFormat, command)) {
+        return 1;
+    }
+    return processCommand(json_line, command, backend, options);
+}
+
+// ------------------------------ Benchmark: re-sends the same payload N times and reports throughput and tail latency ------------------------------ //
+// Meant for --backend=simulator load tests; the first iteration includes backend loading.
+int runBenchmark(const std::string& json_line, int iterations, std::unique_ptr<IDisplayBackend>& backend, const WrapperOptions& options) {
+    std::vector<double> durationsMs;
+    durationsMs.reserve(iterations);
+
+    // Every iteration has to reach the backend, identical content must not be short-circuited
+    WrapperOptions benchOptions = options;
+    benchOptions.force = true;
+    int failedRuns = 0;
+
+    auto benchStart = std::chrono::steady_clock::now();
+    for (int run = 0; run < iterations; ++run) {
+        auto runStart = std::chrono::steady_clock::now();
+        if (processPayload(json_line, backend, benchOptions) != 0) {
+            ++failedRuns;
+        }
+        durationsMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count());
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - benchStart).count();
+
+    std::sort(durationsMs.begin(), durationsMs.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(p * (durationsMs.size() - 1) + 0.5);
+        return durationsMs[rank];
+    };
+
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                      BENCHMARK SUMMARY                             ");
+    WLOG_INFO(L"====================================================================");
+    ResultRecord record;
+    record["success"] = failedRuns == 0;
+    record["benchmark"] = {
+        { "iterations", iterations },
+        { "failedRuns", failedRuns },
+        { "totalMs", totalMs },
+        { "sendsPerSecond", totalMs > 0.0 ? iterations * 1000.0 / totalMs : 0.0 },
+        { "p50Ms", percentile(0.50) },
+        { "p90Ms", percentile(0.90) },
+        { "p99Ms", percentile(0.99) },
+        { "maxMs", durationsMs.back() },
+    };
+    writeResult(record);
+
+    return failedRuns == 0 ? 0 : 1;
+}
+
+// ------------------------------ Maps the precompiled glyph widths (glyph_cache_tool) for the whole process ------------------------------ //
+// Without --glyph-cache the file is optional: glyph-cache.bin next to the executable, if it exists.
+void loadGlyphCache(const std::string& explicitPath, const std::string& executablePath) {
+    std::string path = explicitPath;
+    if (path.empty()) {
+        std::filesystem::path candidate = std::filesystem::path(executablePath).parent_path() / "glyph-cache.bin";
+        std::error_code ec;
+        if (!std::filesystem::exists(candidate, ec)) {
+            return;
+        }
+        path = candidate.string();
+    }
+
+    TraceSpan span("glyphCache");
+    auto startTime = std::chrono::steady_clock::now();
+    try {
+        std::shared_ptr<GlyphCache> cache = GlyphCache::open(path);
+        auto openUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+        WLOG_INFO(L"[FONT] [OK] Glyph cache mapped: " << cache->entryCount() << L" entries (" << openUs << L" us)");
+        setGlyphCache(cache);
+    } catch (const std::exception& e) {
+        std::string err = e.what();
+        WLOG_WARN(L"[FONT] [!] " << widen(err) << L", measuring from the font files");
+    }
+}
+
+// ------------------------------ Main Cpp Application ------------------------------ //
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    // ---------- Global handler to catch any unhandled exceptions ---------- //
+    SetUnhandledExceptionFilter(MyUnhandledExceptionFilter);
+    prepareCrashHandlerStack();
+
+    // ---------- Raw stdin: MessagePack frames must not go through CRLF translation (JSON lines drop the '\r' themselves) ---------- //
+    _setmode(_fileno(stdin), _O_BINARY);
+#else
+    installCrashSignalHandlers();
+
+    // ---------- wcerr needs a UTF-8 locale to print non-ASCII characters ---------- //
+    if (!std::setlocale(LC_ALL, "C.UTF-8")) {
+        std::setlocale(LC_ALL, "");
+    }
+#endif
+
+    // ---------- Results as UTF-8 lines on stdout, the log on stderr (UTF-16 console text on Windows) ---------- //
+    initResultChannel();
+
+    // ---------- Log lines are buffered; whatever is left goes out on every return from main ---------- //
+    std::atexit(flushLog);
+
+    // ---------- Command line flags ---------- //
+    bool isDaemon = false;
+    int benchIterations = 0;
+    std::string replayPath;
+    std::string healthCachePath;
+    std::string glyphCachePath;
+    std::string fleetSource;
+    std::string perfTracePath;
+    std::string metricsPath;
+    std::string flightRecorderFile;
+    int metricsIntervalSeconds = 15;
+    FleetOptions fleetOptions;
+    WrapperOptions options;
+    BackendOptions& backendOptions = options.backend;
+    options.executablePath = currentExecutablePath(argv[0]);
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "--daemon") {
+            isDaemon = true;
+        } else if (arg == "--force") {
+            options.force = true;
+            fleetOptions.force = true;
+        } else if (arg.rfind("--backend=", 0) == 0) {
+            backendOptions.kind = arg.substr(10);
+        } else if (arg.rfind("--sdk=", 0) == 0) {
+            backendOptions.sdkPath = arg.substr(6);
+        } else if (arg.rfind("--sim-config=", 0) == 0) {
+            backendOptions.simConfigPath = arg.substr(13);
+        } else if (arg.rfind("--record=", 0) == 0) {
+            backendOptions.recordPath = arg.substr(9);
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            replayPath = arg.substr(9);
+        } else if (arg.rfind("--bench=", 0) == 0) {
+            benchIterations = std::atoi(arg.substr(8).c_str());
+        } else if (arg.rfind("--health-cache=", 0) == 0) {
+            healthCachePath = arg.substr(15);
+        } else if (arg.rfind("--glyph-cache=", 0) == 0) {
+            glyphCachePath = arg.substr(14);
+        } else if (arg.rfind("--fleet=", 0) == 0) {
+            fleetSource = arg.substr(8);
+        } else if (arg.rfind("--prices=", 0) == 0) {
+            fleetOptions.pricesPath = arg.substr(9);
+        } else if (arg.rfind("--fleet-workers=", 0) == 0) {
+            fleetOptions.workers = std::atoi(arg.substr(16).c_str());
+        } else if (arg.rfind("--controller-concurrency=", 0) == 0) {
+            fleetOptions.perControllerLimit = std::atoi(arg.substr(25).c_str());
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            perfTracePath = arg.substr(8);
+        } else if (arg.rfind("--metrics=", 0) == 0) {
+            metricsPath = arg.substr(10);
+        } else if (arg.rfind("--metrics-interval=", 0) == 0) {
+            metricsIntervalSeconds = std::atoi(arg.substr(19).c_str());
+        } else if (arg.rfind("--flight-recorder=", 0) == 0) {
+            flightRecorderFile = arg.substr(18);
+        } else if (arg == "--quiet") {
+            setLogLevel(LogLevel::Off);
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            LogLevel level = LogLevel::Info;
+            if (!parseLogLevel(arg.substr(12), level)) {
+                writeResult(errorResult("Unknown log level (off, error, warn, info, debug)"));
+                return 1;
             }
-        } else {
-            totalWidth = nWidth * static_cast<int>(fuelItems.size());
-            totalHeight = nHeight;
-            if (isDoubleSided) {
-                totalWidth *= 2;
-                std::wcout << L"[LAYOUT] Double-sided enabled - doubling width" << std::endl;
+            setLogLevel(level);
+        } else if (arg.rfind("--input-format=", 0) == 0) {
+            if (!parsePayloadFormat(arg.substr(15), options.inputFormat)) {
+                writeResult(errorResult("Unknown input format (json, msgpack)"));
+                return 1;
             }
         }
-        
-        std::wcout << L"[LAYOUT] [OK] Total screen size: " << totalWidth << L"x" << totalHeight << L" pixels" << std::endl;
+    }
 
-        // ---------- Create the screen in memory using DLL ---------- //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                      SCREEN CREATION                               " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        
-        std::wcout << L"[SCREEN] Creating screen buffer: " << totalWidth << L"x" << totalHeight << L" pixels" << std::endl;
-        if (Hd_CreateScreen_ptr(totalWidth, totalHeight, 0, 1, nCardType, nullptr, 0) != 0) {
-            throw std::runtime_error("Hd_CreateScreen failed with code: " + std::to_string(Hd_GetSDKLastError_ptr()));
+    // ---------- Phase timings in Chrome Trace Event format, written when the process exits ---------- //
+    if (!perfTracePath.empty()) {
+        enablePerfTrace(perfTracePath);
+        std::atexit(writePerfTrace);
+    }
+
+    // ---------- SDK call counters and latency histograms, rewritten periodically for a textfile collector ---------- //
+    if (!metricsPath.empty()) {
+        enableMetrics(metricsPath, metricsIntervalSeconds);
+        std::atexit(writeMetrics);
+    }
+
+    // ---------- Recent phases and SDK calls in a crash-proof ring (decoded by flight_recorder_tool) ---------- //
+    if (!flightRecorderFile.empty()) {
+        try {
+            openFlightRecorder(flightRecorderFile);
+            recordFlightEvent(FlightEventKind::ProcessStart, isDaemon ? "daemon" : "wrapper", backendOptions.kind.c_str());
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            WLOG_WARN(L"[CRASH] [!] " << widen(err) << L", running without the flight recorder");
         }
-        std::wcout << L"[SCREEN] [OK] Screen buffer created successfully" << std::endl;
+    }
 
-        // ---------- Add a program to the screen ---------- //
-        std::wcout << L"[SCREEN] Creating program container..." << std::endl;
-        int nProgramID = Hd_AddProgram_ptr(nullptr, 0, 0, nullptr, 0);
-        if (nProgramID == -1) {
-            throw std::runtime_error("Hd_AddProgram failed with code: " + std::to_string(Hd_GetSDKLastError_ptr()));
+    WLOG_INFO(L"\n");
+    WLOG_INFO(L"====================================================================");
+    WLOG_INFO(L"          LED DISPLAY CONTROLLER - C++ WRAPPER v1.0                ");
+    WLOG_INFO(L"====================================================================");
+
+    loadGlyphCache(glyphCachePath, options.executablePath);
+
+    std::unique_ptr<IDisplayBackend> backend;
+
+    // ---------- Controller health survives between commands (daemon) and runs (cache file) ---------- //
+    ControllerHealthCache healthCache(healthCachePath);
+
+    // ------------------------------ Replay mode: re-run a recorded trace against the scripted simulator ------------------------------ //
+    if (!replayPath.empty()) {
+        // Skipping "dead" controllers would change the recorded call sequence
+        try {
+            // Nothing may reach a real controller: the fan-out and the time sync run on the scripted simulator too
+            WrapperOptions replayOptions = options;
+            replayOptions.backend.kind = "simulator";
+            replayOptions.backend.recordPath.clear();
+            return replayTrace(replayPath, [&replayOptions](const std::string& payload, std::unique_ptr<IDisplayBackend>& replayBackend,
+                                                            const SideBackendFactory& sideBackends) {
+                replayOptions.inputFormat = sniffPayloadFormat(payload);
+                replayOptions.sideBackends = sideBackends;
+                return processPayload(payload, replayBackend, replayOptions);
+            });
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            writeResult(errorResult(err));
+            return 1;
         }
-        std::wcout << L"[SCREEN] [OK] Program created (ID: " << nProgramID << L")" << std::endl;
+    }
 
-        // ---------- Loop through all fuel items (and possibly twice if double-sided) ---------- //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                   ADDING CONTENT TO SCREEN                         " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        
-        int originalFuelCount = static_cast<int>(fuelItems.size());
-        int totalPasses = isDoubleSided ? 2 : 1;
-        std::wcout << L"[CONTENT] Adding " << originalFuelCount << L" fuel item(s)" 
-                   << (isDoubleSided ? L" × 2 sides" : L"") << std::endl;
-
-        for (int pass = 0; pass < totalPasses; ++pass) {
-            for (int i = 0; i < originalFuelCount; ++i) {
-                auto& item = fuelItems[i];
-                int index = i + pass * originalFuelCount; // Adjust index for second side
-
-                // ---------- Determine coordinates for this fuel item area ---------- //
-                int currentX, currentY;
-                if (rowColumn_str == "C") {
-                    currentX = 0;
-                    currentY = index * nHeight;
-                } else {
-                    currentX = index * nWidth;
-                    currentY = 0;
-                }
-
-                std::wcout << L"\n[AREA " << index << L"] Creating area at position (X=" << currentX << L", Y=" << currentY << L")" << std::endl;
-
-                // ---------- Add area to the screen ---------- //
-                int nAreaID = Hd_AddArea_ptr(nProgramID, currentX, currentY, nWidth, nHeight, nullptr, 0, 5, nullptr, 0);
-                if (nAreaID == -1) {
-                    throw std::runtime_error("Hd_AddArea for item " + std::to_string(index) +
-                                             " failed with code: " + std::to_string(Hd_GetSDKLastError_ptr()));
-                }
-                std::wcout << L"[AREA " << index << L"] [OK] Hd_AddArea SUCCESS (Area ID: " << nAreaID << L")" << std::endl;
-
-                // ---------- Format fuel price and split into integer and decimal parts ---------- //
-                double fuel_price = item["price"];
-                std::wstringstream ss;
-                ss << std::fixed << std::setprecision(2) << fuel_price;
-                std::wstring fullPriceText = ss.str();
-
-                // Split price into integer and decimal parts (e.g., "3.50" -> "3" and ".50")
-                size_t dotPos = fullPriceText.find(L'.');
-                std::wstring integerPart;
-                std::wstring decimalPart;
-                
-                if (dotPos != std::wstring::npos) {
-                    integerPart = fullPriceText.substr(0, dotPos);
-                    decimalPart = fullPriceText.substr(dotPos); // includes the dot
-                } else {
-                    // No decimal point found (shouldn't happen with precision(2), but just in case)
-                    integerPart = fullPriceText;
-                    decimalPart = L".00";
-                }
-
-                std::wcout << L"[AREA " << index << L"] Price: " << fullPriceText 
-                           << L" (split into '" << integerPart << L"' + '" << decimalPart << L"')" << std::endl;
-
-                // ---------- Add integer part with regular font height ---------- //
-                std::wcout << L"[AREA " << index << L"] Adding integer part '" << integerPart 
-                           << L"' (font size: " << nFontHeight << L", position: X=0)" << std::endl;
-                
-                int nIntegerItemID = Hd_AddSimpleTextAreaItem_ptr(
-                    nAreaID, (void*)integerPart.c_str(), 255, 0, 0x0004,
-                    (void*)fontName_ws.c_str(), nFontHeight, 0, 25, 0, 65535, nullptr, 0);
-
-                if (nIntegerItemID == -1) {
-                    throw std::runtime_error("Hd_AddSimpleTextAreaItem (integer) for item " + std::to_string(index) +
-                                             " failed with code: " + std::to_string(Hd_GetSDKLastError_ptr()));
-                }
-                std::wcout << L"[AREA " << index << L"] [OK] Integer text SUCCESS (Item ID: " << nIntegerItemID << L")" << std::endl;
-
-                // ---------- Calculate X position for decimal part ---------- //
-                // Estimate character width: approximately 0.6 * font height for most monospace-ish fonts
-                // Adjust this multiplier if needed based on your specific font
-                double charWidthRatio = 0.6;
-                int estimatedIntegerWidth = static_cast<int>(integerPart.length() * nFontHeight * charWidthRatio);
-
-                // ---------- Add decimal part with smaller font height ---------- //
-                std::wcout << L"[AREA " << index << L"] Adding decimal part '" << decimalPart 
-                           << L"' (font size: " << nDecimalFontHeight 
-                           << L", position: X=" << estimatedIntegerWidth << L")" << std::endl;
-                
-                int nDecimalItemID = Hd_AddSimpleTextAreaItem_ptr(
-                    nAreaID, (void*)decimalPart.c_str(), 255, estimatedIntegerWidth, 0x0004,
-                    (void*)fontName_ws.c_str(), nDecimalFontHeight, 0, 25, 0, 65535, nullptr, 0);
-
-                if (nDecimalItemID == -1) {
-                    throw std::runtime_error("Hd_AddSimpleTextAreaItem (decimal) for item " + std::to_string(index) +
-                                             " failed with code: " + std::to_string(Hd_GetSDKLastError_ptr()));
-                }
-                std::wcout << L"[AREA " << index << L"] [OK] Decimal text SUCCESS (Item ID: " << nDecimalItemID << L")" << std::endl;
-            }
+    // ------------------------------ Fleet mode: push prices to every station of a directory or manifest ------------------------------ //
+    if (!fleetSource.empty()) {
+        fleetOptions.backendOptions = backendOptions;
+        fleetOptions.executablePath = options.executablePath;
+        fleetOptions.health = &healthCache;
+        try {
+            return runFleet(fleetSource, fleetOptions);
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            writeResult(errorResult(err));
+            return 1;
         }
+    }
 
-        // ------------------------------ Send final screen data to the LED display device ------------------------------ //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                    SENDING TO DISPLAY                              " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        
-        std::wcout << L"[SEND] Target display: " << ip_address_ws << std::endl;
-        std::wcout << L"[SEND] Transmitting screen data..." << std::endl;
-        bool sendScreenSuccess = false;
-        if (Hd_SendScreen_ptr(0, (void*)ip_address_ws.c_str(), nullptr, nullptr, 0) != 0) {
-            // If sending fails, log error code and possible hint but continue execution
-            int errorCode = Hd_GetSDKLastError_ptr();
-            std::wcout << L"[SEND] [X] FAILED (Error code: " << errorCode << L")";
-            if (errorCode == 13) {
-                std::wcout << L"\n[SEND] [!] HINT: Timeout error - check device power, network, IP address, firewall";
-            }
-            std::wcout << std::endl;
-            sendScreenSuccess = false;
-        } else {
-            std::wcout << L"[SEND] [OK] SUCCESS - Screen data transmitted to display" << std::endl;
-            sendScreenSuccess = true;
+    options.health = &healthCache;
+
+    // ------------------------------ Single-shot mode: one payload, one result, exit ------------------------------ //
+    if (!isDaemon) {
+        // ---------- Read JSON input (piped from electron) ---------- //
+        WLOG_INFO(L"\n[INPUT] Reading " << (options.inputFormat == PayloadFormat::MessagePack ? L"MessagePack" : L"JSON")
+                  << L" payload from stdin...");
+        std::string json_line;
+        try {
+            TraceSpan span("readInput");
+            readPayloadFrame(std::cin, options.inputFormat, json_line);
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            writeResult(errorResult(err));
+            return 1;
         }
 
-        // ------------------------------ Adjust time on time display if requested ------------------------------ //
-        bool adjustTimeSuccess = false;
-        if (adjustTime_str == "Y" || adjustTime_str == "y") {
-            std::wcout << L"\n====================================================================" << std::endl;
-            std::wcout << L"                    TIME SYNCHRONIZATION                            " << std::endl;
-            std::wcout << L"====================================================================" << std::endl;
-            
-            if (!Cmd_AdjustTime_ptr) {
-                std::wcout << L"[TIME] [X] SKIPPED - Function not available in DLL" << std::endl;
-            } else if (timeDisplayIpAddress_str.empty()) {
-                std::wcout << L"[TIME] [X] SKIPPED - No time display IP configured" << std::endl;
-            } else {
-                // Convert time display IP to wide string
-                std::wstring timeDisplayIp_ws(timeDisplayIpAddress_str.begin(), timeDisplayIpAddress_str.end());
-                std::wcout << L"[TIME] Target display: " << timeDisplayIp_ws << std::endl;
-                std::wcout << L"[TIME] Synchronizing with system time..." << std::endl;
-                
-                if (Cmd_AdjustTime_ptr(0, (void*)timeDisplayIp_ws.c_str(), nullptr) != 0) {
-                    // If time adjustment fails, log error but don't throw (non-critical)
-                    int errorCode = Hd_GetSDKLastError_ptr();
-                    std::wcout << L"[TIME] [X] FAILED (Error code: " << errorCode << L")";
-                    if (errorCode == 13) {
-                        std::wcout << L"\n[TIME] [!] HINT: Timeout - check power, network, IP address";
-                    }
-                    std::wcout << std::endl;
-                    adjustTimeSuccess = false;
-                } else {
-                    std::wcout << L"[TIME] [OK] SUCCESS - Time display synchronized" << std::endl;
-                    adjustTimeSuccess = true;
-                }
+        int exitCode = benchIterations > 0
+            ? runBenchmark(json_line, benchIterations, backend, options)
+            : processPayload(json_line, backend, options);
+
+        // ---------- Unload DLL from memory ---------- //
+        backend.reset();
+        return exitCode;
+    }
+
+    // ------------------------------ Daemon mode: one command per line (or frame), one JSON result line per command ------------------------------ //
+    // The backend stays loaded between commands, so only the first command pays for LoadLibraryW/dlopen and symbol lookup.
+    // The ready line tells the client which input formats it may switch to with {"command": "setFormat", "format": ...}.
+    WLOG_INFO(L"[DAEMON] Waiting for newline-delimited JSON commands on stdin...");
+    ResultRecord ready;
+    ready["ready"] = true;
+    ready["inputFormat"] = payloadFormatName(options.inputFormat);
+    ready["inputFormats"] = { "json", "msgpack" };
+    writeResult(ready);
+    std::string json_line;
+    while (true) {
+        flushLog();
+        try {
+            if (!readPayloadFrame(std::cin, options.inputFormat, json_line)) {
+                break;
             }
-        } else {
-            adjustTimeSuccess = true; // Not requested, so count as "success"
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            writeResult(errorResult(err));
+            break;
+        }
+        if (json_line.empty()) {
+            continue;
         }
 
-        // ---------- Unload DLL from memory ---------- //
-        FreeLibrary(hDll);
+        // ---------- One parse per command; control commands ({"command": "ping"} / {"command": "shutdown"}) carry nothing else ---------- //
+        PayloadCommand command;
+        if (!readCommandLine(json_line, options.inputFormat, command)) {
+            continue;
+        }
 
-        // ---------- Output final status message in JSON format ---------- //
-        std::wcout << L"\n====================================================================" << std::endl;
-        std::wcout << L"                        FINAL SUMMARY                               " << std::endl;
-        std::wcout << L"====================================================================" << std::endl;
-        std::wcout << L"  Screen Send:     " << (sendScreenSuccess ? L"[OK] SUCCESS" : L"[X] FAILED") << std::endl;
-        std::wcout << L"  Time Adjust:     " << (adjustTimeSuccess ? L"[OK] SUCCESS" : L"[X] FAILED") << std::endl;
-        std::wcout << L"====================================================================\n" << std::endl;
-        
-        if (sendScreenSuccess && adjustTimeSuccess) {
-            std::wcout << L"{\"success\": true, \"message\": \"Screen data sent and time adjusted successfully.\", \"sendScreen\": true, \"adjustTime\": true}" << std::endl;
-        } else if (sendScreenSuccess && !adjustTimeSuccess) {
-            std::wcout << L"{\"success\": true, \"message\": \"Screen data sent successfully, but time adjustment failed.\", \"sendScreen\": true, \"adjustTime\": false}" << std::endl;
-        } else if (!sendScreenSuccess && adjustTimeSuccess) {
-            std::wcout << L"{\"success\": true, \"message\": \"Screen send failed, but time adjustment succeeded.\", \"sendScreen\": false, \"adjustTime\": true}" << std::endl;
-        } else {
-            std::wcout << L"{\"success\": false, \"message\": \"Both screen send and time adjustment failed.\", \"sendScreen\": false, \"adjustTime\": false}" << std::endl;
+        if (command.command == "shutdown") {
+            writeResult({ { "success", true }, { "message", "Daemon shutting down." } });
+            break;
+        }
+        if (command.command == "ping") {
+            writeResult({ { "success", true }, { "message", "pong" }, { "sdkLoaded", backend != nullptr } });
+            continue;
+        }
+        if (command.command == "setFormat") {
+            // Everything after this command arrives in the new format
+            bool known = parsePayloadFormat(command.format, options.inputFormat);
+            writeResult({ { "success", known }, { "inputFormat", payloadFormatName(options.inputFormat) } });
+            continue;
         }
 
-    } catch (const std::exception& e) {
-        // ---------- Catch and report any exceptions during processing ---------- //
-        std::string err = e.what();
-        std::wcout << L"{\"success\": false, \"error\": \"" << std::wstring(err.begin(), err.end()) << L"\"}" << std::endl;
-        return 1;
+        WLOG_INFO(L"\n[DAEMON] Command received");
+        processCommand(json_line, command, backend, options);
+        // A daemon is usually killed rather than shut down, so the trace is kept current
+        if (perfTraceEnabled()) {
+            writePerfTrace();
+        }
     }
 
-    // Exit successfully
+    // ---------- Unload DLL from memory ---------- //
+    backend.reset();
     return 0;
 }
\ No newline at end of file
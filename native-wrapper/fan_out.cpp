@@ -0,0 +1,276 @@
+#include "fan_out.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "child_process.hpp"
+#include "flight_recorder.hpp"
+#include "glyph_cache.hpp"
+#include "json.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
+#include "perf_trace.hpp"
+#include "utf8.hpp"
+
+using json = nlohmann::json;
+
+std::vector<std::string> childBackendArguments(const BackendOptions& options, const std::string& recordSuffix) {
+    std::vector<std::string> args;
+    // Only the result line of a child is read back, its log would just fill the pipe
+    args.push_back("--quiet");
+    args.push_back("--backend=" + options.kind);
+    if (!options.sdkPath.empty()) args.push_back("--sdk=" + options.sdkPath);
+    if (!options.simConfigPath.empty()) args.push_back("--sim-config=" + options.simConfigPath);
+    if (!options.recordPath.empty()) args.push_back("--record=" + options.recordPath + recordSuffix);
+    // The child's spans come back through its own trace file (see mergeChildPerfTrace)
+    std::string tracePath = childPerfTracePath(recordSuffix);
+    if (!tracePath.empty()) args.push_back("--trace=" + tracePath);
+    // Children write into the same ring, so a crashing child leaves its calls next to the parent's
+    if (flightRecorderEnabled()) args.push_back("--flight-recorder=" + flightRecorderPath());
+    // Children lay out their display themselves, with the same glyph widths
+    if (std::shared_ptr<const GlyphCache> cache = glyphCache()) args.push_back("--glyph-cache=" + cache->path());
+    return args;
+}
+
+namespace {
+
+// ---------- A child's stdout holds only result records; its result is the last one ---------- //
+std::string lastJsonLine(const std::string& output) {
+    std::string lastLine;
+    size_t lineStart = 0;
+    while (lineStart < output.size()) {
+        size_t lineEnd = output.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = output.size();
+        std::string line = output.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty() && line[0] == '{') lastLine = line;
+        lineStart = lineEnd + 1;
+    }
+    return lastLine;
+}
+
+} // namespace
+
+DisplayResult parseChildDisplayResult(const std::string& output, const std::string& displayIpAddress) {
+    DisplayResult result;
+    result.displayIpAddress = displayIpAddress;
+
+    std::string resultLine = lastJsonLine(output);
+    if (resultLine.empty()) {
+        result.error = "Child wrapper produced no result";
+        return result;
+    }
+
+    try {
+        json childResult = json::parse(resultLine);
+        if (childResult.contains("displays") && !childResult["displays"].empty()) {
+            const json& display = childResult["displays"][0];
+            result.success = display.value("success", false);
+            result.errorCode = display.value("errorCode", 0);
+            result.error = display.value("error", "");
+            result.attempts = display.value("attempts", 0);
+            result.attemptMs = display.value("attemptMs", std::vector<double>());
+            result.errorCategory = display.value("errorCategory", "");
+            if (display.contains("areas")) readAreas(display["areas"], result.areas);
+            if (display.contains("sdkCalls")) readSdkCalls(display["sdkCalls"], result.sdkCalls);
+        } else {
+            result.error = childResult.value("error", "Child wrapper reported no display result");
+        }
+    } catch (json::exception& e) {
+        result.error = std::string("Unreadable child wrapper result: ") + e.what();
+    }
+    return result;
+}
+
+std::vector<DisplayResult> sendToDisplaysConcurrently(const Payload& payload, const FanOutContext& context) {
+    size_t displayCount = payload.displays.size();
+    std::vector<DisplayResult> results(displayCount);
+    bool inProcess = context.sideBackends || supportsIndependentInstances(context.backendOptions);
+    unsigned workerCount = static_cast<unsigned>(std::min<size_t>(displayCount, static_cast<size_t>(payload.maxParallelDisplays)));
+
+    WLOG_INFO(L"[FANOUT] Sending to " << displayCount << L" display(s) with up to " << workerCount
+              << (inProcess ? L" worker thread(s)" : L" child process(es)"));
+
+    TraceSpan span("fanOut", "wrapper", "displays", static_cast<int64_t>(displayCount));
+    std::atomic<size_t> nextDisplay(0);
+    auto worker = [&]() {
+        prepareCrashHandlerStack();
+        for (size_t index = nextDisplay++; index < displayCount; index = nextDisplay++) {
+            TraceSpan displaySpan("display", "wrapper", "index", static_cast<int64_t>(index));
+            const DisplayConfig& display = payload.displays[index];
+            std::string recordSuffix = ".display" + std::to_string(index);
+            auto startTime = std::chrono::steady_clock::now();
+
+            ScreenModel model;
+            try {
+                model = buildScreenModel(display, payload.fuelItems);
+            } catch (const std::exception& e) {
+                // A grid that does not fit fails its own display, never the worker thread
+                results[index].displayIpAddress = display.displayIpAddress;
+                results[index].error = e.what();
+                results[index].durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                continue;
+            }
+            results[index] = sendIfChanged(context.health, display.displayIpAddress, screenModelHash(model), payload.force, [&]() {
+                DisplayResult result;
+                result.displayIpAddress = display.displayIpAddress;
+                try {
+                    if (context.sideBackends) {
+                        std::unique_ptr<IDisplayBackend> workerBackend = context.sideBackends(recordSuffix);
+                        result = sendToDisplay(*workerBackend, display, model, payload.retry);
+                    } else if (inProcess) {
+                        BackendOptions workerOptions = context.backendOptions;
+                        if (!workerOptions.recordPath.empty()) workerOptions.recordPath += recordSuffix;
+                        std::unique_ptr<IDisplayBackend> workerBackend = createDisplayBackend(workerOptions);
+                        result = sendToDisplay(*workerBackend, display, model, payload.retry);
+                    } else {
+                        TraceSpan childSpan("childProcess");
+                        ChildProcessResult child = runChildProcess(
+                            context.executablePath,
+                            childBackendArguments(context.backendOptions, recordSuffix),
+                            singleDisplayPayloadJson(display, payload.fuelItems, payload.retry) + "\n");
+                        childSpan.end();
+                        mergeChildPerfTrace(childPerfTracePath(recordSuffix));
+                        result = parseChildDisplayResult(child.output, display.displayIpAddress);
+                        recordSdkCalls(display.displayIpAddress, display.cardType, result.sdkCalls);
+                    }
+                } catch (const std::exception& e) {
+                    result.success = false;
+                    result.error = e.what();
+                }
+                result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                return result;
+            });
+            results[index].fontFit = model.fontFit;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < workerCount; ++w) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    // ---------- Per-display summary ---------- //
+    for (const DisplayResult& result : results) {
+        WLOG_INFO(L"[FANOUT] " << widen(result.displayIpAddress) << L": " << (result.success ? L"[OK] SUCCESS" : L"[X] FAILED")
+                  << (result.errorCode != 0 ? L" (Error code: " + std::to_wstring(result.errorCode) + L")" : std::wstring())
+                  << (result.error.empty() ? std::wstring() : L" - " + widen(result.error))
+                  << L" in " << result.durationMs << L" ms");
+    }
+    return results;
+}
+
+TimeSyncResult parseChildTimeSyncResult(const std::string& output) {
+    TimeSyncResult result;
+    std::string resultLine = lastJsonLine(output);
+    try {
+        json childResult = json::parse(resultLine.empty() ? std::string("{}") : resultLine);
+        result.success = childResult.value("adjustTime", false);
+        result.attempts = childResult.value("adjustTimeAttempts", 0);
+        result.errorCode = childResult.value("adjustTimeErrorCode", 0);
+        if (childResult.contains("timeSync") && childResult["timeSync"].contains("sdkCalls")) {
+            readSdkCalls(childResult["timeSync"]["sdkCalls"], result.sdkCalls);
+        }
+    } catch (json::exception&) {
+        result.success = false;
+    }
+    return result;
+}
+
+TimeSyncTask::TimeSyncTask(const Payload& payload, const FanOutContext& context)
+    : timeSync(payload.timeSync), health(context.health), startTime(std::chrono::steady_clock::now()) {
+    immediateResult.success = true; // Not requested, so count as "success"
+    if (!timeSync.adjustTime) {
+        return;
+    }
+
+    const std::string& ip = timeSync.timeDisplayIpAddress;
+    if (health && !ip.empty() && !health->allowAttempt(ip)) {
+        WLOG_ERROR(L"[HEALTH] [X] Skipping time sync of " << widen(ip) << L" - circuit open");
+        immediateResult.success = false;
+        immediateResult.skipped = true;
+        immediateResult.errorCode = health->snapshot(ip).lastErrorCode;
+        return;
+    }
+
+    // ---------- Everything the background work needs is copied into it ---------- //
+    std::shared_ptr<std::promise<TimeSyncResult>> promise(new std::promise<TimeSyncResult>());
+    future = promise->get_future();
+    started = true;
+
+    TimeSyncConfig syncConfig = payload.timeSync;
+    RetryPolicy retry = payload.retry;
+    // No new attempt once wait() has given up
+    retry.deadlineMs = std::min(retry.deadlineMs, timeSync.timeoutMs);
+    BackendOptions backendOptions = context.backendOptions;
+    SideBackendFactory sideBackends = context.sideBackends;
+    std::string executablePath = context.executablePath;
+
+    worker = std::thread([promise, syncConfig, retry, backendOptions, sideBackends, executablePath]() {
+        prepareCrashHandlerStack();
+        TraceSpan span("timeSyncTask");
+        TimeSyncResult result;
+        try {
+            if (sideBackends || supportsIndependentInstances(backendOptions)) {
+                BackendOptions syncOptions = backendOptions;
+                if (!syncOptions.recordPath.empty()) syncOptions.recordPath += ".timesync";
+                std::unique_ptr<IDisplayBackend> syncBackend = sideBackends ? sideBackends(".timesync") : createDisplayBackend(syncOptions);
+                result = syncTime(*syncBackend, syncConfig, retry);
+            } else {
+                // HDSDK shares its last error with the screen sends, so the sync gets a process of its own; a hung
+                // Cmd_AdjustTime is killed with it at the timeout
+                ChildProcessResult child = runChildProcess(
+                    executablePath,
+                    childBackendArguments(backendOptions, ".timesync"),
+                    timeSyncPayloadJson(syncConfig, retry) + "\n",
+                    syncConfig.timeoutMs);
+                mergeChildPerfTrace(childPerfTracePath(".timesync"));
+                result = parseChildTimeSyncResult(child.output);
+                if (child.timedOut) result.errorCode = 13;
+                recordSdkCalls(syncConfig.timeDisplayIpAddress, "", result.sdkCalls);
+            }
+        } catch (const std::exception& e) {
+            std::string err = e.what();
+            WLOG_ERROR(L"[TIME] [X] FAILED - " << widen(err));
+            result.success = false;
+        }
+        promise->set_value(result);
+    });
+}
+
+// ---------- Bounded: a child wrapper is killed at the timeout, in-process retries stop there ---------- //
+TimeSyncTask::~TimeSyncTask() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+TimeSyncResult TimeSyncTask::wait() {
+    if (!started) {
+        return immediateResult;
+    }
+
+    TraceSpan span("timeSyncWait");
+    TimeSyncResult result;
+    double latencyMs = 0.0;
+    if (future.wait_until(startTime + std::chrono::milliseconds(timeSync.timeoutMs)) == std::future_status::ready) {
+        result = future.get();
+        worker.join();
+        latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    } else {
+        WLOG_ERROR(L"[TIME] [X] FAILED - no answer within " << timeSync.timeoutMs << L" ms, not waiting any longer");
+        result.success = false;
+        result.errorCode = 13;
+        latencyMs = timeSync.timeoutMs;
+    }
+
+    if (health && !timeSync.timeDisplayIpAddress.empty() && (result.success || result.errorCode != 0)) {
+        health->recordOutcome(timeSync.timeDisplayIpAddress, result.success, result.errorCode, latencyMs);
+    }
+    return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "display_backend.hpp"
+#include "health_cache.hpp"
+#include "payload.hpp"
+#include "send_pipeline.hpp"
+#include "trace_backend.hpp"
+
+// ------------------------------ What the fan-out needs besides the payload ------------------------------ //
+struct FanOutContext {
+    BackendOptions backendOptions;
+    std::string executablePath;     // this wrapper, re-launched per display when the backend is process-global
+    ControllerHealthCache* health = nullptr;  // skips controllers with an open circuit, may be null
+    SideBackendFactory sideBackends;    // replay: scripted in-process backends per record suffix instead of backendOptions
+};
+
+// ------------------------------ Sends every display of the payload, at most maxParallelDisplays at a time ------------------------------ //
+// Backends with independent instances (simulator) run on a bounded thread pool, one backend per worker.
+// HDSDK keeps one global screen per process, so each display is sent by a child wrapper process instead.
+// Results are returned in the order of payload.displays; failures never abort the other displays.
+std::vector<DisplayResult> sendToDisplaysConcurrently(const Payload& payload, const FanOutContext& context);
+
+// ------------------------------ Time sync running next to the screen sends, on a background thread ------------------------------ //
+// The clock and the price signs are different controllers, so neither has to wait for the other. Backends with
+// independent instances get a fresh one; HDSDK gets a child wrapper running a syncTime command, which is killed once
+// timeSync.timeoutMs has passed. wait() reports a timeout at the same point and in-process retries stop there, so the
+// destructor never waits much longer than the timeout. Health is checked on start and recorded in wait().
+class TimeSyncTask {
+public:
+    TimeSyncTask(const Payload& payload, const FanOutContext& context);
+    ~TimeSyncTask();
+    TimeSyncTask(const TimeSyncTask&) = delete;
+    TimeSyncTask& operator=(const TimeSyncTask&) = delete;
+
+    // ---------- Blocks until the sync is done or its timeout has passed ---------- //
+    TimeSyncResult wait();
+
+private:
+    TimeSyncConfig timeSync;
+    ControllerHealthCache* health = nullptr;
+    bool started = false;
+    TimeSyncResult immediateResult;     // not requested / skipped by the health cache
+    std::future<TimeSyncResult> future;
+    std::thread worker;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// ------------------------------ Extracts the time sync result from a child wrapper's syncTime output ------------------------------ //
+TimeSyncResult parseChildTimeSyncResult(const std::string& output);
+
+// ------------------------------ Command line that makes a child wrapper use the same backend ------------------------------ //
+std::vector<std::string> childBackendArguments(const BackendOptions& options, const std::string& recordSuffix);
+
+// ------------------------------ Extracts the per-display result from a child wrapper's output ------------------------------ //
+DisplayResult parseChildDisplayResult(const std::string& output, const std::string& displayIpAddress);
@@ -0,0 +1,510 @@
+#include "fleet.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include "child_process.hpp"
+#include "fan_out.hpp"
+#include "flight_recorder.hpp"
+#include "json.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
+#include "perf_trace.hpp"
+#include "result_channel.hpp"
+#include "station_ini.hpp"
+#include "utf8.hpp"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string readTextFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// ---------- Shared price list: [{name, price}, ...] (saved-fuel-items.json) or {"fuelItems": [...]} ---------- //
+json loadPrices(const std::string& path) {
+    if (path.empty()) {
+        return json::array();
+    }
+    json prices = json::parse(readTextFile(path));
+    if (prices.is_object() && prices.contains("fuelItems")) {
+        prices = prices["fuelItems"];
+    }
+    if (!prices.is_array()) {
+        throw std::runtime_error("Price file must hold an array of fuel items: " + path);
+    }
+    return prices;
+}
+
+// ---------- Fuel items in the station's fuelNames order; unlike the app we refuse to push a missing price as 0.00 ---------- //
+json selectFuelItems(const json& config, const json& prices) {
+    if (!config.contains("fuelNames")) {
+        return prices;
+    }
+    json items = json::array();
+    for (const json& fuelName : config["fuelNames"]) {
+        auto match = std::find_if(prices.begin(), prices.end(), [&](const json& item) {
+            return item.value("name", "") == fuelName.get<std::string>();
+        });
+        if (match == prices.end()) {
+            throw std::runtime_error("No price for fuel '" + fuelName.get<std::string>() + "'");
+        }
+        items.push_back(*match);
+    }
+    return items;
+}
+
+// ---------- Full payloads pass through; bare configs (parseIniContent shape) get displays and prices attached ---------- //
+json stationPayload(const json& station, const json& prices) {
+    if (station.contains("config")) {
+        json payload = station;
+        if (!payload.contains("fuelItems")) {
+            payload["fuelItems"] = selectFuelItems(payload["config"], prices);
+        }
+        return payload;
+    }
+
+    json payload = {
+        {"config", station},
+        {"displays", station.value("displays", json::array())},
+        {"fuelItems", selectFuelItems(station, prices)}
+    };
+    return payload;
+}
+
+FleetStation makeStation(const std::string& name, const std::function<json()>& readStation, const json& prices) {
+    FleetStation station;
+    station.name = name;
+    try {
+        json payload = stationPayload(readStation(), prices);
+        station.payload = readPayloadCommand(payload.dump()).payload;
+        if (station.payload.fuelItems.empty()) {
+            throw std::runtime_error("FuelItems array is empty.");
+        }
+    } catch (const std::exception& e) {
+        station.loadError = e.what();
+    }
+    return station;
+}
+
+// ------------------------------ Deque owned by one worker: the owner works from the back, thieves take from the front ------------------------------ //
+class WorkQueue {
+public:
+    void pushBack(size_t job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+
+    void pushFront(size_t job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_front(job);
+    }
+
+    bool popBack(size_t& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+
+    bool stealFront(size_t& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+};
+
+// ------------------------------ Caps concurrent sends per controller IP ------------------------------ //
+class ControllerLimiter {
+public:
+    explicit ControllerLimiter(int limit) : limit(limit) {}
+
+    bool tryAcquire(const std::string& controller) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int& active = activeSends[controller];
+        if (active >= limit) return false;
+        ++active;
+        return true;
+    }
+
+    void release(const std::string& controller) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeSends[controller];
+        }
+        released.notify_all();
+    }
+
+    // ---------- Called when every job a worker can see is blocked; wakes on the next release ---------- //
+    void waitForRelease() {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait_for(lock, std::chrono::milliseconds(10));
+    }
+
+private:
+    int limit;
+    std::mutex mutex;
+    std::condition_variable released;
+    std::unordered_map<std::string, int> activeSends;
+};
+
+// ---------- One unit of scheduled work: a display send or a station's time sync ---------- //
+struct FleetJob {
+    size_t station = 0;
+    size_t display = 0;
+    bool isTimeSync = false;
+    std::string controller;
+};
+
+} // namespace
+
+std::vector<FleetStation> loadFleet(const std::string& source, const std::string& pricesPath) {
+    json prices = loadPrices(pricesPath);
+    std::vector<FleetStation> stations;
+
+    if (fs::is_directory(source)) {
+        // ---------- Directory: one station per .ini / .json file, in file name order ---------- //
+        std::vector<fs::path> files;
+        for (const fs::directory_entry& entry : fs::directory_iterator(source)) {
+            std::string extension = entry.path().extension().string();
+            if (entry.is_regular_file() && (extension == ".ini" || extension == ".json")) {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        for (const fs::path& file : files) {
+            stations.push_back(makeStation(file.filename().string(), [&file]() {
+                std::string contents = readTextFile(file);
+                return file.extension() == ".ini" ? parseStationIni(contents) : json::parse(contents);
+            }, prices));
+        }
+    } else {
+        // ---------- Manifest: shared prices plus a "stations" array ---------- //
+        json manifest = json::parse(readTextFile(source));
+        if (!manifest.contains("stations") || !manifest["stations"].is_array()) {
+            throw std::runtime_error("Fleet manifest has no \"stations\" array: " + source);
+        }
+        if (manifest.contains("fuelItems") && prices.empty()) {
+            prices = manifest["fuelItems"];
+        }
+
+        const json& entries = manifest["stations"];
+        for (size_t s = 0; s < entries.size(); ++s) {
+            const json& entry = entries[s];
+            std::string name = entry.is_object() ? entry.value("name", "") : "";
+            if (name.empty()) name = "station-" + std::to_string(s + 1);
+            stations.push_back(makeStation(name, [&entry]() { return entry; }, prices));
+        }
+    }
+
+    if (stations.empty()) {
+        throw std::runtime_error("No stations found in " + source);
+    }
+    return stations;
+}
+
+int runFleet(const std::string& source, const FleetOptions& options) {
+    TraceSpan span("fleet");
+    auto fleetStart = std::chrono::steady_clock::now();
+
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                        FLEET PUSH                                  ");
+    WLOG_INFO(L"====================================================================");
+
+    TraceSpan loadSpan("loadFleet");
+    std::vector<FleetStation> stations = loadFleet(source, options.pricesPath);
+    loadSpan.end();
+    std::vector<FleetStationResult> results(stations.size());
+
+    // ---------- Flatten stations into jobs, one per display plus one per time sync ---------- //
+    std::vector<FleetJob> jobs;
+    std::vector<std::atomic<int>> pendingJobs(stations.size());
+    for (size_t s = 0; s < stations.size(); ++s) {
+        const FleetStation& station = stations[s];
+        results[s].name = station.name;
+        results[s].error = station.loadError;
+        results[s].timeSync.success = true;
+        pendingJobs[s] = 0;
+        if (!station.loadError.empty()) continue;
+
+        results[s].displays.resize(station.payload.displays.size());
+        for (size_t d = 0; d < station.payload.displays.size(); ++d) {
+            FleetJob job;
+            job.station = s;
+            job.display = d;
+            job.controller = station.payload.displays[d].displayIpAddress;
+            jobs.push_back(job);
+            ++pendingJobs[s];
+        }
+        if (station.payload.timeSync.adjustTime) {
+            FleetJob job;
+            job.station = s;
+            job.isTimeSync = true;
+            job.controller = station.payload.timeSync.timeDisplayIpAddress;
+            jobs.push_back(job);
+            ++pendingJobs[s];
+        }
+    }
+
+    bool inProcess = supportsIndependentInstances(options.backendOptions);
+    unsigned workerCount = options.workers > 0
+        ? static_cast<unsigned>(options.workers)
+        : std::max(4u, std::thread::hardware_concurrency());
+    workerCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(workerCount, jobs.size())));
+
+    WLOG_INFO(L"[FLEET] " << stations.size() << L" station(s), " << jobs.size() << L" job(s), "
+              << workerCount << (inProcess ? L" worker thread(s)" : L" worker(s) with child processes")
+              << L", at most " << options.perControllerLimit << L" send(s) per controller");
+
+    // ---------- Stations that failed to load are finished before any work starts ---------- //
+    std::mutex outputMutex;
+    size_t stationsDone = 0;
+    auto reportStation = [&](size_t s) {
+        FleetStationResult& result = results[s];
+        result.success = result.error.empty() && result.timeSync.success;
+        for (const DisplayResult& display : result.displays) {
+            result.success = result.success && display.success;
+        }
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        ++stationsDone;
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fleetStart).count();
+        WLOG_INFO(L"[FLEET] " << (result.success ? L"[OK] " : L"[X] ") << widen(result.name)
+                  << (result.error.empty() ? std::wstring() : L" - " + widen(result.error))
+                  << L" (" << stationsDone << L"/" << stations.size() << L" stations, " << elapsedMs << L" ms)");
+        // Progress streams: the buffered log otherwise only goes out with the fleet result
+        flushLog();
+    };
+    for (size_t s = 0; s < stations.size(); ++s) {
+        if (!stations[s].loadError.empty()) reportStation(s);
+    }
+
+    // ---------- Jobs are dealt round-robin; idle workers steal from the front of other queues ---------- //
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned w = 0; w < workerCount; ++w) {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        queues[j % workerCount]->pushBack(j);
+    }
+
+    ControllerLimiter limiter(std::max(1, options.perControllerLimit));
+    std::atomic<size_t> remainingJobs(jobs.size());
+    std::atomic<uint64_t> steals(0);
+
+    auto runJob = [&](const FleetJob& job, std::unique_ptr<IDisplayBackend>& workerBackend, unsigned workerIndex) {
+        const FleetStation& station = stations[job.station];
+        FleetStationResult& result = results[job.station];
+        std::string recordSuffix = ".worker" + std::to_string(workerIndex);
+        TraceSpan span(job.isTimeSync ? "fleetTimeSync" : "fleetDisplay", "wrapper", "station", static_cast<int64_t>(job.station));
+
+        if (inProcess && !workerBackend) {
+            BackendOptions workerOptions = options.backendOptions;
+            if (!workerOptions.recordPath.empty()) workerOptions.recordPath += recordSuffix;
+            workerBackend = createDisplayBackend(workerOptions);
+        }
+
+        if (job.isTimeSync) {
+            result.timeSync = syncWithHealthCheck(options.health, station.payload.timeSync, [&]() {
+                if (inProcess) {
+                    return syncTime(*workerBackend, station.payload.timeSync, station.payload.retry);
+                }
+                // A child per sync, like the display sends, killed at the sync timeout: a hung clock holds its worker no longer
+                TimeSyncResult syncResult;
+                try {
+                    ChildProcessResult child = runChildProcess(
+                        options.executablePath,
+                        childBackendArguments(options.backendOptions, recordSuffix),
+                        timeSyncPayloadJson(station.payload.timeSync, station.payload.retry) + "\n",
+                        station.payload.timeSync.timeoutMs);
+                    mergeChildPerfTrace(childPerfTracePath(recordSuffix));
+                    syncResult = parseChildTimeSyncResult(child.output);
+                    if (child.timedOut) syncResult.errorCode = 13;
+                    recordSdkCalls(station.payload.timeSync.timeDisplayIpAddress, "", syncResult.sdkCalls);
+                } catch (const std::exception& e) {
+                    std::string err = e.what();
+                    WLOG_ERROR(L"[TIME] [X] FAILED - " << widen(err));
+                    syncResult.success = false;
+                }
+                return syncResult;
+            });
+            return;
+        }
+
+        const DisplayConfig& display = station.payload.displays[job.display];
+        ScreenModel model;
+        try {
+            model = buildScreenModel(display, station.payload.fuelItems);
+        } catch (const std::exception& e) {
+            // A grid that does not fit fails this display only, the station's other displays still go out
+            result.displays[job.display].displayIpAddress = display.displayIpAddress;
+            result.displays[job.display].error = e.what();
+            return;
+        }
+        bool force = options.force || station.payload.force;
+        result.displays[job.display] = sendIfChanged(options.health, display.displayIpAddress, screenModelHash(model), force, [&]() {
+            auto startTime = std::chrono::steady_clock::now();
+            DisplayResult displayResult;
+            displayResult.displayIpAddress = display.displayIpAddress;
+            try {
+                if (inProcess) {
+                    displayResult = sendToDisplay(*workerBackend, display, model, station.payload.retry);
+                } else {
+                    ChildProcessResult child = runChildProcess(
+                        options.executablePath,
+                        childBackendArguments(options.backendOptions, recordSuffix),
+                        singleDisplayPayloadJson(display, station.payload.fuelItems, station.payload.retry) + "\n");
+                    mergeChildPerfTrace(childPerfTracePath(recordSuffix));
+                    displayResult = parseChildDisplayResult(child.output, display.displayIpAddress);
+                    recordSdkCalls(display.displayIpAddress, display.cardType, displayResult.sdkCalls);
+                }
+            } catch (const std::exception& e) {
+                displayResult.success = false;
+                displayResult.error = e.what();
+            }
+            displayResult.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            return displayResult;
+        });
+        result.displays[job.display].fontFit = model.fontFit;
+    };
+
+    auto worker = [&](unsigned workerIndex) {
+        prepareCrashHandlerStack();
+        std::unique_ptr<IDisplayBackend> workerBackend;
+        WorkQueue& ownQueue = *queues[workerIndex];
+        size_t blockedInARow = 0;
+
+        while (remainingJobs.load() > 0) {
+            size_t jobIndex = 0;
+            bool found = ownQueue.popBack(jobIndex);
+            bool stolen = false;
+            for (unsigned offset = 1; !found && offset < workerCount; ++offset) {
+                found = stolen = queues[(workerIndex + offset) % workerCount]->stealFront(jobIndex);
+            }
+            if (!found) {
+                // Everything left is in flight on other workers
+                limiter.waitForRelease();
+                continue;
+            }
+
+            const FleetJob& job = jobs[jobIndex];
+            if (!limiter.tryAcquire(job.controller)) {
+                // Controller busy: park the job where thieves look first and try other work
+                ownQueue.pushFront(jobIndex);
+                if (++blockedInARow > ownQueue.size()) {
+                    limiter.waitForRelease();
+                    blockedInARow = 0;
+                }
+                continue;
+            }
+            blockedInARow = 0;
+            if (stolen) ++steals;
+
+            try {
+                runJob(job, workerBackend, workerIndex);
+            } catch (const std::exception& e) {
+                // Backend creation failed; the station is reported with the error
+                std::lock_guard<std::mutex> lock(outputMutex);
+                results[job.station].error = e.what();
+                if (job.isTimeSync) results[job.station].timeSync.success = false;
+            }
+            limiter.release(job.controller);
+
+            if (--pendingJobs[job.station] == 0) {
+                reportStation(job.station);
+            }
+            --remainingJobs;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < workerCount; ++w) {
+        workers.emplace_back(worker, w);
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    if (options.health) options.health->save();
+
+    // ------------------------------ Fleet summary ------------------------------ //
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fleetStart).count();
+    size_t stationsFailed = 0, displaysTotal = 0, displaysFailed = 0, displaysSkipped = 0;
+    for (const FleetStationResult& result : results) {
+        if (!result.success) ++stationsFailed;
+        for (const DisplayResult& display : result.displays) {
+            ++displaysTotal;
+            if (!display.success) ++displaysFailed;
+            if (display.skipped) ++displaysSkipped;
+        }
+    }
+
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                       FLEET SUMMARY                                ");
+    WLOG_INFO(L"====================================================================");
+    WLOG_INFO(L"  Stations:        " << (stations.size() - stationsFailed) << L"/" << stations.size() << L" succeeded");
+    WLOG_INFO(L"  Displays:        " << (displaysTotal - displaysFailed) << L"/" << displaysTotal << L" succeeded ("
+              << displaysSkipped << L" skipped, circuit open)");
+    WLOG_INFO(L"  Duration:        " << totalMs << L" ms (" << steals.load() << L" jobs stolen)");
+    WLOG_INFO(L"====================================================================\n");
+
+    ResultRecord record;
+    record["success"] = stationsFailed == 0;
+    record["fleet"] = {
+        { "stations", stations.size() },
+        { "stationsFailed", stationsFailed },
+        { "displays", displaysTotal },
+        { "displaysFailed", displaysFailed },
+        { "displaysSkipped", displaysSkipped },
+        { "workers", workerCount },
+        { "steals", steals.load() },
+        { "totalMs", totalMs },
+        { "stationsPerSecond", totalMs > 0.0 ? stations.size() * 1000.0 / totalMs : 0.0 },
+    };
+    ResultRecord& stationRecords = record["stations"] = ResultRecord::array();
+    for (const FleetStationResult& result : results) {
+        ResultRecord station;
+        station["name"] = result.name;
+        station["success"] = result.success;
+        station["adjustTime"] = result.timeSync.success;
+        station["displays"] = displaysJson(result.displays);
+        station["timeSync"] = timeSyncJson(result.timeSync);
+        if (!result.error.empty()) {
+            station["error"] = result.error;
+        }
+        stationRecords.push_back(std::move(station));
+    }
+    writeResult(record);
+
+    return stationsFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "display_backend.hpp"
+#include "health_cache.hpp"
+#include "payload.hpp"
+#include "send_pipeline.hpp"
+
+// ------------------------------ Fleet push: one price update for many stations (--fleet=<dir|manifest.json>) ------------------------------ //
+// Sources:
+//   directory      every *.ini (station config, same keys as the app's .ini) and *.json file is one station;
+//                  .json files hold either a full payload ({"config", "displays", "fuelItems"}) or a bare config
+//   manifest.json  {"fuelItems": [...], "stations": [config | payload, ...]}
+// Stations without their own fuel items get the shared list (--prices=<file.json> or the manifest's "fuelItems"),
+// filtered and ordered by the station's fuelNames when it has them.
+struct FleetOptions {
+    BackendOptions backendOptions;
+    std::string executablePath;     // this wrapper, re-launched per display when the backend is process-global
+    std::string pricesPath;         // --prices=<file.json>, array of {name, price} or {"fuelItems": [...]}
+    int workers = 0;                // --fleet-workers=<n>, 0 = one per hardware thread (at least 4)
+    int perControllerLimit = 1;     // --controller-concurrency=<n>, concurrent sends to the same controller IP
+    ControllerHealthCache* health = nullptr;  // dead controllers are skipped instead of stalling a worker until timeout
+    bool force = false;             // --force, resend stations whose signs already show the new prices
+};
+
+// ------------------------------ One station of the fleet and its outcome ------------------------------ //
+struct FleetStation {
+    std::string name;               // file name or manifest "name"
+    Payload payload;
+    std::string loadError;          // set when the station could not be read; it is reported but never sent
+};
+
+struct FleetStationResult {
+    std::string name;
+    std::vector<DisplayResult> displays;
+    TimeSyncResult timeSync;
+    std::string error;
+    bool success = false;
+};
+
+// ------------------------------ Reads every station from a directory or manifest, throws if the source is unusable ------------------------------ //
+std::vector<FleetStation> loadFleet(const std::string& source, const std::string& pricesPath);
+
+// ------------------------------ Pushes all stations and prints progress lines plus one JSON summary line ------------------------------ //
+int runFleet(const std::string& source, const FleetOptions& options);
@@ -0,0 +1,333 @@
+#include "flight_recorder.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "json.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> flightRecorderActive(false);
+
+namespace {
+
+// ------------------------------ File layout (native byte order) ------------------------------ //
+//   RingHeader | write index | padding to 64 | uint64 committed[capacity] | FlightEvent events[capacity]
+// committed[slot] is the event's sequence + 1 once the slot is completely written.
+const char kMagic[8] = { 'N', 'Z', 'F', 'L', 'I', 'G', 'H', 'T' };
+const uint32_t kByteOrderMark = 0x01020304;
+const uint32_t kFormatVersion = 1;
+const uint32_t kCapacity = 4096;            // ~500 KiB: the last few dozen sends with every call and argument
+
+struct RingHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t eventSize;
+    uint64_t reserved;
+};
+
+const size_t kWriteIndexOffset = sizeof(RingHeader);
+const size_t kCommittedOffset = 64;
+
+// Other processes and the decoder read the same bytes
+static_assert(sizeof(FlightEvent) == 128, "FlightEvent layout is part of the file format");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "ring counters are plain 64-bit words in the file");
+
+size_t eventsOffset(uint32_t capacity) {
+    return kCommittedOffset + capacity * sizeof(uint64_t);
+}
+
+size_t ringSize(uint32_t capacity) {
+    return eventsOffset(capacity) + capacity * sizeof(FlightEvent);
+}
+
+bool validHeader(const RingHeader& header) {
+    return memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.byteOrder == kByteOrderMark &&
+           header.version == kFormatVersion && header.capacity == kCapacity && header.eventSize == sizeof(FlightEvent);
+}
+
+// ---------- The mapped ring; set up once in openFlightRecorder and never unmapped ---------- //
+struct Ring {
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    std::atomic<uint64_t>* writeIndex = nullptr;
+    std::atomic<uint64_t>* committed = nullptr;
+    FlightEvent* events = nullptr;
+    std::string path;
+    std::string pathJson;
+#ifdef _WIN32
+    HANDLE file = nullptr;
+#endif
+};
+
+Ring ring;
+
+uint32_t processId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+uint32_t threadNumber() {
+    static std::atomic<uint32_t> nextThread(1);
+    thread_local uint32_t number = nextThread++;
+    return number;
+}
+
+// ---------- Truncates without splitting a UTF-8 sequence ---------- //
+void copyText(char* dest, size_t capacity, const char* text) {
+    size_t length = strlen(text);
+    if (length >= capacity) {
+        length = capacity - 1;
+        while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) --length;
+    }
+    memcpy(dest, text, length);
+    dest[length] = '\0';
+}
+
+} // namespace
+
+void openFlightRecorder(const std::string& path) {
+    size_t size = ringSize(kCapacity);
+    void* view = nullptr;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open flight recorder: " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart != static_cast<LONGLONG>(size)) {
+        // A ring of another layout starts over (extending fills with zeros)
+        LARGE_INTEGER zero = {};
+        LARGE_INTEGER wanted;
+        wanted.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file, zero, nullptr, FILE_BEGIN) || !SetEndOfFile(file) ||
+            !SetFilePointerEx(file, wanted, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to size flight recorder: " + path);
+        }
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map flight recorder: " + path);
+    }
+    view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    CloseHandle(mapping);
+    if (!view) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map flight recorder: " + path);
+    }
+    ring.file = file;
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open flight recorder: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size != static_cast<off_t>(size)) {
+        // A ring of another layout starts over (extending fills with zeros)
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to size flight recorder: " + path);
+        }
+    }
+    view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Failed to map flight recorder: " + path);
+    }
+#endif
+
+    ring.base = static_cast<uint8_t*>(view);
+    ring.size = size;
+    RingHeader* header = reinterpret_cast<RingHeader*>(ring.base);
+    if (!validHeader(*header)) {
+        memset(ring.base, 0, size);
+        memcpy(header->magic, kMagic, sizeof(kMagic));
+        header->byteOrder = kByteOrderMark;
+        header->version = kFormatVersion;
+        header->capacity = kCapacity;
+        header->eventSize = sizeof(FlightEvent);
+    }
+    ring.writeIndex = reinterpret_cast<std::atomic<uint64_t>*>(ring.base + kWriteIndexOffset);
+    ring.committed = reinterpret_cast<std::atomic<uint64_t>*>(ring.base + kCommittedOffset);
+    ring.events = reinterpret_cast<FlightEvent*>(ring.base + eventsOffset(kCapacity));
+    ring.path = path;
+    ring.pathJson = nlohmann::json(path).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    flightRecorderActive.store(true, std::memory_order_release);
+}
+
+const std::string& flightRecorderPath() {
+    return ring.path;
+}
+
+const char* flightRecorderPathJson() {
+    return ring.pathJson.c_str();
+}
+
+void recordFlightEvent(FlightEventKind kind, const char* name, const char* detail, int32_t value, int area,
+                       std::initializer_list<int32_t> args) {
+    if (!flightRecorderEnabled()) return;
+
+    uint64_t sequence = ring.writeIndex->fetch_add(1, std::memory_order_relaxed);
+    size_t slot = static_cast<size_t>(sequence % kCapacity);
+    ring.committed[slot].store(0, std::memory_order_relaxed);
+
+    FlightEvent& event = ring.events[slot];
+    memset(&event, 0, sizeof(event));
+    event.sequence = sequence;
+    event.steadyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    event.wallClockMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    event.processId = processId();
+    event.threadNumber = threadNumber();
+    event.kind = static_cast<uint16_t>(kind);
+    event.area = static_cast<int16_t>(area);
+    event.value = value;
+    size_t a = 0;
+    for (int32_t arg : args) {
+        if (a == 4) break;
+        event.args[a++] = arg;
+    }
+    copyText(event.name, sizeof(event.name), name);
+    copyText(event.detail, sizeof(event.detail), detail);
+
+    ring.committed[slot].store(sequence + 1, std::memory_order_release);
+}
+
+CrashContext findCrashContext() {
+    CrashContext context;
+    if (!flightRecorderEnabled()) return context;
+
+    uint32_t pid = processId();
+    uint32_t thread = threadNumber();
+    uint64_t end = ring.writeIndex->load(std::memory_order_acquire);
+    uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+    bool sdkCallSettled = false;
+    for (uint64_t sequence = end; sequence-- > begin;) {
+        size_t slot = static_cast<size_t>(sequence % kCapacity);
+        if (ring.committed[slot].load(std::memory_order_acquire) != sequence + 1) continue;
+        const FlightEvent& event = ring.events[slot];
+        if (event.processId != pid || event.threadNumber != thread) continue;
+
+        FlightEventKind kind = static_cast<FlightEventKind>(event.kind);
+        if (kind == FlightEventKind::ProcessStart) break;
+        if (!sdkCallSettled && (kind == FlightEventKind::SdkCall || kind == FlightEventKind::SdkReturn)) {
+            // The latest SDK event decides: a call without its return is where the crash happened
+            sdkCallSettled = true;
+            if (kind == FlightEventKind::SdkCall) {
+                context.sdkCall = event.name;
+                memcpy(context.args, event.args, sizeof(context.args));
+            }
+        }
+        if (kind == FlightEventKind::Phase) {
+            if (strcmp(event.name, "area") == 0) {
+                context.area = event.area;
+                break;
+            }
+            // Areas before the start of this send belong to an earlier display
+            if (strcmp(event.name, "sendToDisplay") == 0 || strcmp(event.name, "syncTime") == 0) break;
+        }
+    }
+    return context;
+}
+
+void flushFlightRecorder() {
+    if (!flightRecorderEnabled()) return;
+#ifdef _WIN32
+    FlushViewOfFile(ring.base, 0);
+    FlushFileBuffers(ring.file);
+#else
+    msync(ring.base, ring.size, MS_SYNC);
+#endif
+}
+
+#ifndef _WIN32
+namespace {
+
+// ---------- The calling thread's alternate signal stack, released with the thread ---------- //
+struct CrashHandlerStack {
+    std::vector<char> memory;
+
+    CrashHandlerStack() : memory(64 * 1024) {
+        stack_t stack = {};
+        stack.ss_sp = memory.data();
+        stack.ss_size = memory.size();
+        sigaltstack(&stack, nullptr);
+    }
+
+    ~CrashHandlerStack() {
+        stack_t stack = {};
+        stack.ss_flags = SS_DISABLE;
+        sigaltstack(&stack, nullptr);
+    }
+};
+
+} // namespace
+#endif
+
+void prepareCrashHandlerStack() {
+#ifdef _WIN32
+    ULONG guaranteedBytes = 64 * 1024;
+    SetThreadStackGuarantee(&guaranteedBytes);
+#else
+    thread_local CrashHandlerStack stack;
+    (void)stack;
+#endif
+}
+
+std::vector<FlightEvent> readFlightRecording(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open flight recording: " + path);
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    RingHeader header;
+    if (data.size() < kCommittedOffset) {
+        throw std::runtime_error("Not a flight recording: " + path);
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a flight recording: " + path);
+    }
+    if (!validHeader(header) || data.size() != ringSize(header.capacity)) {
+        throw std::runtime_error("Flight recording was written by another platform or version: " + path);
+    }
+
+    uint64_t end = 0;
+    memcpy(&end, data.data() + kWriteIndexOffset, sizeof(end));
+    uint64_t begin = end > header.capacity ? end - header.capacity : 0;
+
+    std::vector<FlightEvent> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t sequence = begin; sequence < end; ++sequence) {
+        size_t slot = static_cast<size_t>(sequence % header.capacity);
+        uint64_t committed = 0;
+        memcpy(&committed, data.data() + kCommittedOffset + slot * sizeof(uint64_t), sizeof(committed));
+        if (committed != sequence + 1) continue;   // being written when the process died, or already overwritten
+
+        FlightEvent event;
+        memcpy(&event, data.data() + eventsOffset(header.capacity) + slot * sizeof(FlightEvent), sizeof(event));
+        event.name[sizeof(event.name) - 1] = '\0';
+        event.detail[sizeof(event.detail) - 1] = '\0';
+        events.push_back(event);
+    }
+    return events;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// ------------------------------ Crash flight recorder (--flight-recorder=<file.bin>) ------------------------------ //
+// A fixed-size ring of the most recent structured events in a memory-mapped file: phases, every HDSDK call with its
+// arguments before it is made, and what it returned. The pages belong to the OS, so they survive a crash of the
+// process; the crash handlers only add the crash event and flush the mapping to disk. The ring is kept across runs
+// and shared with child wrappers (one atomic increment claims a slot). Decode it with flight_recorder_tool.
+enum class FlightEventKind : uint16_t { ProcessStart = 1, Phase = 2, SdkCall = 3, SdkReturn = 4, Crash = 5 };
+
+// ---------- One event as stored in the ring ---------- //
+struct FlightEvent {
+    uint64_t sequence;          // claim order across every process writing the ring
+    int64_t steadyNs;           // monotonic, for durations between events
+    int64_t wallClockMs;        // system clock, to line events up with logs
+    uint32_t processId;
+    uint32_t threadNumber;      // small per-process thread number
+    uint16_t kind;              // FlightEventKind
+    int16_t area;               // area index, -1 when not about an area
+    int32_t value;              // return value, exception code or signal
+    int32_t args[4];
+    char name[32];              // SDK function or phase, NUL-terminated
+    char detail[40];            // IP, text or content hash, UTF-8, NUL-terminated, cut at a character boundary
+};
+
+extern std::atomic<bool> flightRecorderActive;
+
+inline bool flightRecorderEnabled() {
+    return flightRecorderActive.load(std::memory_order_relaxed);
+}
+
+// ---------- Maps the ring, reusing an existing one of the same layout; std::runtime_error when it cannot ---------- //
+void openFlightRecorder(const std::string& path);
+const std::string& flightRecorderPath();
+
+// ---------- Does nothing until the ring is open; never allocates or locks, so crash handlers record too ---------- //
+void recordFlightEvent(FlightEventKind kind, const char* name, const char* detail = "", int32_t value = 0, int area = -1,
+                       std::initializer_list<int32_t> args = {});
+
+// ------------------------------ For crash handlers: no allocation, no locks ------------------------------ //
+// The crashing thread's SDK call that never returned, and the area it was working on.
+struct CrashContext {
+    const char* sdkCall = nullptr;      // points into the ring
+    int32_t args[4] = { 0, 0, 0, 0 };
+    int area = -1;
+};
+CrashContext findCrashContext();
+void flushFlightRecorder();
+const char* flightRecorderPathJson();   // the path as a quoted JSON string
+
+// ---------- Reserves stack for the crash handler on the calling thread, so a stack overflow still reports ---------- //
+// sigaltstack / SetThreadStackGuarantee are per thread: call it first thing on every thread that calls into the SDK.
+void prepareCrashHandlerStack();
+
+// ---------- Decoder: the committed events of a ring file, oldest first ---------- //
+std::vector<FlightEvent> readFlightRecording(const std::string& path);
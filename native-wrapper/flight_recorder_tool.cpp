@@ -0,0 +1,148 @@
+// ------------------------------ flight_recorder_tool - prints the last events of a dll_wrapper flight recorder ------------------------------ //
+//   flight_recorder_tool --dump=flight-recorder.bin [--last=50] [--pid=<process id>]
+// dll_wrapper writes the ring with --flight-recorder=<file>; after a crash the last CALL without a RETURN is where it died.
+
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "flight_recorder.hpp"
+#include "log.hpp"
+#include "utf8.hpp"
+
+#ifndef _WIN32
+#include <clocale>
+#endif
+
+namespace {
+
+void printUsage() {
+    std::wcout << L"Usage:\n"
+               << L"  flight_recorder_tool --dump=<flight-recorder.bin> [--last=<N>] [--pid=<process id>]\n"
+               << L"Prints the last N events (default 50), oldest first." << std::endl;
+}
+
+// ---------- "2026-10-17 21:18:03.123" in local time ---------- //
+std::wstring formatWallClock(int64_t wallClockMs) {
+    std::time_t seconds = static_cast<std::time_t>(wallClockMs / 1000);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    std::wostringstream out;
+    out << std::put_time(&local, L"%Y-%m-%d %H:%M:%S") << L"." << std::setw(3) << std::setfill(L'0') << wallClockMs % 1000;
+    return out.str();
+}
+
+std::wstring formatArgs(const FlightEvent& event, int count) {
+    std::wostringstream out;
+    out << L"(";
+    for (int a = 0; a < count; ++a) {
+        out << (a > 0 ? L", " : L"") << event.args[a];
+    }
+    out << L")";
+    return out.str();
+}
+
+// ---------- Arguments the wrapper records per SDK call (see hdsdk_backend.cpp) ---------- //
+int sdkArgCount(const std::string& name) {
+    if (name == "Hd_AddArea") return 4;
+    if (name == "Hd_CreateScreen" || name == "Hd_AddSimpleTextAreaItem") return 3;
+    return 0;
+}
+
+std::wstring describeEvent(const FlightEvent& event) {
+    std::string name = event.name;
+    std::wstring detail = widen(event.detail);   // a torn or foreign slot must not end the dump
+    std::wostringstream out;
+    switch (static_cast<FlightEventKind>(event.kind)) {
+    case FlightEventKind::ProcessStart:
+        out << L"START   " << widen(name) << (detail.empty() ? L"" : L" (" + detail + L")");
+        break;
+    case FlightEventKind::Phase:
+        out << L"PHASE   " << widen(name);
+        if (event.area >= 0) out << L" " << event.area;
+        if (!detail.empty()) out << L" " << detail;
+        if (event.value != 0) out << L" value=" << event.value;
+        if (event.args[0] || event.args[1] || event.args[2] || event.args[3]) out << L" " << formatArgs(event, 4);
+        break;
+    case FlightEventKind::SdkCall:
+        out << L"CALL    " << widen(name) << formatArgs(event, sdkArgCount(name)) << (detail.empty() ? L"" : L" \"" + detail + L"\"");
+        break;
+    case FlightEventKind::SdkReturn:
+        out << L"RETURN  " << widen(name) << L" -> " << event.value;
+        break;
+    case FlightEventKind::Crash:
+        out << L"CRASH   " << widen(name) << L" " << event.value << L" (0x" << std::hex << static_cast<uint32_t>(event.value) << std::dec << L")";
+        break;
+    default:
+        out << L"?       kind " << event.kind << L" " << widen(name);
+        break;
+    }
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+#ifndef _WIN32
+    if (!std::setlocale(LC_ALL, "C.UTF-8")) {
+        std::setlocale(LC_ALL, "");
+    }
+#endif
+    std::atexit(flushLog);
+
+    std::string dumpPath;
+    size_t lastCount = 50;
+    long processFilter = -1;
+
+    try {
+        for (int a = 1; a < argc; ++a) {
+            std::string arg = argv[a];
+            if (arg.rfind("--dump=", 0) == 0) {
+                dumpPath = arg.substr(7);
+            } else if (arg.rfind("--last=", 0) == 0) {
+                lastCount = static_cast<size_t>(std::atol(arg.substr(7).c_str()));
+            } else if (arg.rfind("--pid=", 0) == 0) {
+                processFilter = std::atol(arg.substr(6).c_str());
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+        if (dumpPath.empty()) {
+            printUsage();
+            return 2;
+        }
+
+        std::vector<FlightEvent> events = readFlightRecording(dumpPath);
+        std::vector<FlightEvent> selected;
+        for (const FlightEvent& event : events) {
+            if (processFilter < 0 || event.processId == static_cast<uint32_t>(processFilter)) selected.push_back(event);
+        }
+        size_t first = selected.size() > lastCount ? selected.size() - lastCount : 0;
+
+        std::wcout << L"[FLIGHT] " << events.size() << L" event(s) in the ring, showing the last " << selected.size() - first << L"\n";
+        int64_t previousNs = 0;
+        for (size_t e = first; e < selected.size(); ++e) {
+            const FlightEvent& event = selected[e];
+            double deltaMs = e > first ? (event.steadyNs - previousNs) / 1e6 : 0.0;
+            previousNs = event.steadyNs;
+            std::wcout << std::setw(8) << event.sequence << L"  " << formatWallClock(event.wallClockMs)
+                       << L"  +" << std::fixed << std::setprecision(3) << std::setw(9) << deltaMs << L" ms"
+                       << L"  pid " << event.processId << L"/" << event.threadNumber << L"  " << describeEvent(event) << L"\n";
+        }
+        std::wcout << std::flush;
+        return 0;
+    } catch (const std::exception& e) {
+        std::string err = e.what();
+        WLOG_ERROR(L"[FLIGHT] [X] " << widen(err));
+        return 1;
+    }
+}
@@ -0,0 +1,59 @@
+#include "font_fit.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "font_metrics.hpp"
+
+namespace {
+
+int decimalHeightFor(int fontHeight, double decimalRatio, int moduleHeight) {
+    int decimalHeight = static_cast<int>(std::lround(fontHeight * decimalRatio));
+    return std::max(1, std::min(decimalHeight, moduleHeight));
+}
+
+// ---------- Whether the widest price fits at these heights ---------- //
+bool pricesFit(const std::vector<PriceText>& prices, const std::string& fontName, int fontHeight, int decimalHeight, int moduleWidth) {
+    for (const PriceText& price : prices) {
+        int width = measureTextWidth(price.integerPart, fontName, fontHeight) +
+                    measureTextWidth(price.decimalPart, fontName, decimalHeight);
+        if (width > moduleWidth) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+FontFit fitFontHeights(const std::vector<PriceText>& prices, const std::string& fontName,
+                       int moduleWidth, int moduleHeight, double decimalRatio) {
+    // Locating and parsing the font is a once-per-process cost (logged by [FONT]), not part of the search
+    scaledFont(fontName, 1);
+
+    auto startTime = std::chrono::steady_clock::now();
+    FontFit fit;
+    fit.applied = true;
+
+    // ---------- Largest fitting height in [1, moduleHeight]; wider text never gets narrower with height ---------- //
+    int low = 1;
+    int high = std::max(1, moduleHeight);
+    fit.steps = 1;
+    fit.fits = pricesFit(prices, fontName, low, decimalHeightFor(low, decimalRatio, moduleHeight), moduleWidth);
+    if (fit.fits) {
+        while (low < high) {
+            int mid = low + (high - low + 1) / 2;
+            ++fit.steps;
+            if (pricesFit(prices, fontName, mid, decimalHeightFor(mid, decimalRatio, moduleHeight), moduleWidth)) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+    }
+
+    fit.fontHeight = low;
+    fit.decimalFontHeight = decimalHeightFor(low, decimalRatio, moduleHeight);
+    fit.durationUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    return fit;
+}
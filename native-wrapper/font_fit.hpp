@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// ------------------------------ A price as it is drawn: "3" at the font height, ".50" at the decimal height ------------------------------ //
+struct PriceText {
+    std::wstring integerPart;
+    std::wstring decimalPart;
+};
+
+// ------------------------------ Font heights chosen by auto-fit (AutoFitFont=Y) ------------------------------ //
+struct FontFit {
+    bool applied = false;
+    bool fits = true;               // false = not even height 1 fits, the smallest heights are used
+    int fontHeight = 0;
+    int decimalFontHeight = 0;
+    int steps = 0;                  // heights measured by the search
+    double durationUs = 0.0;
+};
+
+// ------------------------------ Largest heights at which every price fits one module ------------------------------ //
+// Binary search over the integer height (1 .. moduleHeight); the decimal height follows at `decimalRatio`.
+// A price fits when integer width + decimal width <= moduleWidth, measured with measureTextWidth (glyph cache
+// or parsed font metrics), so the widest price across all fuel items decides.
+FontFit fitFontHeights(const std::vector<PriceText>& prices, const std::string& fontName,
+                       int moduleWidth, int moduleHeight, double decimalRatio);
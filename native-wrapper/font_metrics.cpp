@@ -0,0 +1,503 @@
+#include "font_metrics.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include "glyph_cache.hpp"
+#include "log.hpp"
+#include "utf8.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ------------------------------ Big-endian reads with bounds checks ------------------------------ //
+class SfntReader {
+public:
+    SfntReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint8_t u8(size_t offset) const {
+        check(offset, 1);
+        return data[offset];
+    }
+
+    uint16_t u16(size_t offset) const {
+        check(offset, 2);
+        return static_cast<uint16_t>((data[offset] << 8) | data[offset + 1]);
+    }
+
+    int16_t s16(size_t offset) const { return static_cast<int16_t>(u16(offset)); }
+
+    uint32_t u32(size_t offset) const {
+        check(offset, 4);
+        return (static_cast<uint32_t>(data[offset]) << 24) | (static_cast<uint32_t>(data[offset + 1]) << 16) |
+               (static_cast<uint32_t>(data[offset + 2]) << 8) | static_cast<uint32_t>(data[offset + 3]);
+    }
+
+    size_t length() const { return size; }
+
+private:
+    void check(size_t offset, size_t count) const {
+        if (offset + count > size || offset + count < offset) {
+            throw std::runtime_error("Font data truncated");
+        }
+    }
+
+    const uint8_t* data;
+    size_t size;
+};
+
+uint32_t tag(const char* name) {
+    return (static_cast<uint32_t>(name[0]) << 24) | (static_cast<uint32_t>(name[1]) << 16) |
+           (static_cast<uint32_t>(name[2]) << 8) | static_cast<uint32_t>(name[3]);
+}
+
+// ---------- Offset of the face's table directory (resolves .ttc collections) ---------- //
+uint32_t faceOffset(const SfntReader& font, uint32_t faceIndex) {
+    if (font.u32(0) == tag("ttcf")) {
+        uint32_t numFonts = font.u32(8);
+        if (faceIndex >= numFonts) {
+            throw std::runtime_error("Font collection has no face " + std::to_string(faceIndex));
+        }
+        return font.u32(12 + 4 * faceIndex);
+    }
+    if (faceIndex != 0) {
+        throw std::runtime_error("Font file is not a collection");
+    }
+    return 0;
+}
+
+uint32_t faceCount(const SfntReader& font) {
+    return font.u32(0) == tag("ttcf") ? font.u32(8) : 1;
+}
+
+// ---------- Finds a table of the face; returns false if it is missing ---------- //
+bool findTable(const SfntReader& font, uint32_t directory, const char* name, uint32_t& offset, uint32_t& length) {
+    uint32_t version = font.u32(directory);
+    if (version != 0x00010000 && version != tag("OTTO") && version != tag("true")) {
+        throw std::runtime_error("Not a TrueType/OpenType font");
+    }
+
+    uint16_t numTables = font.u16(directory + 4);
+    for (uint16_t t = 0; t < numTables; ++t) {
+        size_t record = directory + 12 + 16 * static_cast<size_t>(t);
+        if (font.u32(record) == tag(name)) {
+            offset = font.u32(record + 8);
+            length = font.u32(record + 12);
+            if (static_cast<size_t>(offset) + length > font.length()) {
+                throw std::runtime_error(std::string("Font table '") + name + "' out of range");
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string lowercase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+// ---------- Lowercase with spaces, dashes and underscores dropped: "Arial Black" == "arialblack" ---------- //
+std::string normalizedName(const std::string& name) {
+    std::string result;
+    for (unsigned char c : name) {
+        if (c != ' ' && c != '-' && c != '_') result += static_cast<char>(std::tolower(c));
+    }
+    return result;
+}
+
+// ------------------------------ Names of the faces in a font file (for FontName lookup) ------------------------------ //
+struct FaceNames {
+    uint32_t faceIndex = 0;
+    std::string family;         // nameID 1
+    std::string subfamily;      // nameID 2
+    std::string fullName;       // nameID 4
+};
+
+// ---------- Windows (3) names are UTF-16BE, Macintosh (1) Roman names single byte; non-ASCII becomes '?' ---------- //
+std::string decodeName(const SfntReader& font, size_t offset, uint16_t length, uint16_t platformId) {
+    std::string name;
+    if (platformId == 3 || platformId == 0) {
+        for (uint16_t i = 0; i + 1 < length; i += 2) {
+            uint16_t unit = font.u16(offset + i);
+            name += unit < 128 ? static_cast<char>(unit) : '?';
+        }
+    } else {
+        for (uint16_t i = 0; i < length; ++i) {
+            uint8_t byte = font.u8(offset + i);
+            name += byte < 128 ? static_cast<char>(byte) : '?';
+        }
+    }
+    return name;
+}
+
+std::vector<FaceNames> readFaceNames(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    SfntReader font(data.data(), data.size());
+
+    std::vector<FaceNames> faces;
+    uint32_t count = faceCount(font);
+    for (uint32_t faceIndex = 0; faceIndex < count; ++faceIndex) {
+        uint32_t directory = faceOffset(font, faceIndex);
+        uint32_t nameOffset = 0, nameLength = 0;
+        if (!findTable(font, directory, "name", nameOffset, nameLength)) continue;
+
+        FaceNames names;
+        names.faceIndex = faceIndex;
+        uint16_t recordCount = font.u16(nameOffset + 2);
+        size_t storage = nameOffset + font.u16(nameOffset + 4);
+        for (uint16_t r = 0; r < recordCount; ++r) {
+            size_t record = nameOffset + 6 + 12 * static_cast<size_t>(r);
+            uint16_t platformId = font.u16(record);
+            uint16_t languageId = font.u16(record + 4);
+            uint16_t nameId = font.u16(record + 6);
+            // English names only: Windows en-US or Macintosh English
+            if (!((platformId == 3 && languageId == 0x0409) || (platformId == 1 && languageId == 0) || platformId == 0)) continue;
+
+            std::string value = decodeName(font, storage + font.u16(record + 10), font.u16(record + 8), platformId);
+            if (nameId == 1 && names.family.empty()) names.family = value;
+            if (nameId == 2 && names.subfamily.empty()) names.subfamily = value;
+            if (nameId == 4 && names.fullName.empty()) names.fullName = value;
+        }
+        faces.push_back(names);
+    }
+    return faces;
+}
+
+// ------------------------------ Font folders of the platform ------------------------------ //
+std::vector<fs::path> fontDirectories() {
+    std::vector<fs::path> directories;
+#ifdef _WIN32
+    const char* windowsDir = std::getenv("WINDIR");
+    directories.push_back(fs::path(windowsDir ? windowsDir : "C:\\Windows") / "Fonts");
+    if (const char* localAppData = std::getenv("LOCALAPPDATA")) {
+        directories.push_back(fs::path(localAppData) / "Microsoft" / "Windows" / "Fonts");
+    }
+#else
+    directories.push_back("/usr/share/fonts");
+    directories.push_back("/usr/local/share/fonts");
+    if (const char* home = std::getenv("HOME")) {
+        directories.push_back(fs::path(home) / ".local" / "share" / "fonts");
+        directories.push_back(fs::path(home) / ".fonts");
+    }
+#endif
+    return directories;
+}
+
+bool isFontFile(const fs::path& path) {
+    std::string extension = lowercase(path.extension().string());
+    return extension == ".ttf" || extension == ".otf" || extension == ".ttc";
+}
+
+std::vector<fs::path> allFontFiles() {
+    std::vector<fs::path> files;
+    for (const fs::path& directory : fontDirectories()) {
+        std::error_code ec;
+        if (!fs::is_directory(directory, ec)) continue;
+        for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), end;
+             it != end; it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec) && isFontFile(it->path())) {
+                files.push_back(it->path());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// ---------- A resolved font: file + face inside it ---------- //
+struct FontLocation {
+    std::string path;
+    uint32_t faceIndex = 0;
+};
+
+FontLocation locateFont(const std::string& fontName) {
+    // ---------- FontName is a path ---------- //
+    if (isFontFile(fs::path(fontName)) && fs::exists(fontName)) {
+        return { fontName, 0 };
+    }
+
+    std::string wanted = normalizedName(fontName);
+    std::vector<fs::path> files = allFontFiles();
+
+    // ---------- Fast path: file name matches ("Arial" -> arial.ttf) ---------- //
+    for (const fs::path& file : files) {
+        if (normalizedName(file.stem().string()) == wanted) {
+            return { file.string(), 0 };
+        }
+    }
+
+    // ---------- Names stored in the fonts: full name, else the regular face of the family ---------- //
+    FontLocation best;
+    int bestScore = 0;
+    for (const fs::path& file : files) {
+        std::vector<FaceNames> faces;
+        try {
+            faces = readFaceNames(file.string());
+        } catch (const std::exception&) {
+            continue; // unreadable font files are not our problem
+        }
+        for (const FaceNames& face : faces) {
+            int score = 0;
+            if (normalizedName(face.fullName) == wanted) {
+                score = 3;
+            } else if (normalizedName(face.family) == wanted) {
+                std::string subfamily = lowercase(face.subfamily);
+                score = (subfamily == "regular" || subfamily == "normal" || subfamily == "book") ? 2 : 1;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                best = { file.string(), face.faceIndex };
+            }
+        }
+        if (bestScore == 3) break;
+    }
+    return best;
+}
+
+} // namespace
+
+// ------------------------------ FontFace ------------------------------ //
+std::shared_ptr<FontFace> FontFace::load(const std::string& path, uint32_t faceIndex) {
+    std::shared_ptr<FontFace> face(new FontFace());
+    face->filePath = path;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open font file: " + path);
+    }
+    face->data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    SfntReader font(face->data.data(), face->data.size());
+    uint32_t directory = faceOffset(font, faceIndex);
+
+    // ---------- head: units per em ---------- //
+    uint32_t offset = 0, length = 0;
+    if (!findTable(font, directory, "head", offset, length)) throw std::runtime_error("Font has no 'head' table: " + path);
+    face->emUnits = font.u16(offset + 18);
+    if (face->emUnits == 0) throw std::runtime_error("Font has unitsPerEm 0: " + path);
+
+    // ---------- hhea + hmtx: advance widths ---------- //
+    if (!findTable(font, directory, "hhea", offset, length)) throw std::runtime_error("Font has no 'hhea' table: " + path);
+    uint16_t numberOfHMetrics = font.u16(offset + 34);
+    if (!findTable(font, directory, "hmtx", offset, length)) throw std::runtime_error("Font has no 'hmtx' table: " + path);
+    face->advances.reserve(numberOfHMetrics);
+    for (uint16_t g = 0; g < numberOfHMetrics; ++g) {
+        face->advances.push_back(font.u16(offset + 4 * static_cast<size_t>(g)));
+    }
+    if (face->advances.empty()) throw std::runtime_error("Font has no horizontal metrics: " + path);
+
+    // ---------- cmap: best Unicode subtable, format 12 (full range) before format 4 (BMP) ---------- //
+    if (!findTable(font, directory, "cmap", offset, length)) throw std::runtime_error("Font has no 'cmap' table: " + path);
+    uint16_t numSubtables = font.u16(offset + 2);
+    int bestRank = 0;
+    for (uint16_t s = 0; s < numSubtables; ++s) {
+        size_t record = offset + 4 + 8 * static_cast<size_t>(s);
+        uint16_t platformId = font.u16(record);
+        uint16_t encodingId = font.u16(record + 2);
+        uint32_t subtable = offset + font.u32(record + 4);
+        uint16_t format = font.u16(subtable);
+
+        bool unicode = platformId == 0 || (platformId == 3 && (encodingId == 1 || encodingId == 10));
+        int rank = 0;
+        if (unicode && format == 12) rank = 2;
+        else if (unicode && format == 4) rank = 1;
+        if (rank > bestRank) {
+            bestRank = rank;
+            face->cmapOffset = subtable;
+            face->cmapFormat = format;
+        }
+    }
+    if (bestRank == 0) throw std::runtime_error("Font has no Unicode cmap (format 4 or 12): " + path);
+
+    // ---------- kern: horizontal format 0 subtables of the Microsoft-style (version 0) table ---------- //
+    if (findTable(font, directory, "kern", offset, length) && font.u16(offset) == 0) {
+        uint16_t nTables = font.u16(offset + 2);
+        size_t subtable = offset + 4;
+        for (uint16_t t = 0; t < nTables; ++t) {
+            uint16_t subtableLength = font.u16(subtable + 2);
+            uint16_t coverage = font.u16(subtable + 4);
+            bool horizontal = (coverage & 0x1) != 0;
+            bool minimum = (coverage & 0x2) != 0;
+            bool crossStream = (coverage & 0x4) != 0;
+            if ((coverage >> 8) == 0 && horizontal && !minimum && !crossStream) {
+                uint16_t nPairs = font.u16(subtable + 6);
+                for (uint16_t p = 0; p < nPairs; ++p) {
+                    size_t pair = subtable + 14 + 6 * static_cast<size_t>(p);
+                    uint32_t key = (static_cast<uint32_t>(font.u16(pair)) << 16) | font.u16(pair + 2);
+                    face->kernPairs[key] = font.s16(pair + 4);
+                }
+            }
+            if (subtableLength == 0) break;
+            subtable += subtableLength;
+        }
+    }
+
+    return face;
+}
+
+uint16_t FontFace::glyphIndex(uint32_t codePoint) const {
+    SfntReader font(data.data(), data.size());
+
+    if (cmapFormat == 12) {
+        uint32_t nGroups = font.u32(cmapOffset + 12);
+        // Groups are sorted by start code: binary search
+        uint32_t low = 0, high = nGroups;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            size_t group = cmapOffset + 16 + 12 * static_cast<size_t>(mid);
+            uint32_t startCode = font.u32(group);
+            uint32_t endCode = font.u32(group + 4);
+            if (codePoint < startCode) {
+                high = mid;
+            } else if (codePoint > endCode) {
+                low = mid + 1;
+            } else {
+                return static_cast<uint16_t>(font.u32(group + 8) + (codePoint - startCode));
+            }
+        }
+        return 0;
+    }
+
+    if (cmapFormat == 4 && codePoint <= 0xFFFF) {
+        uint16_t segCount = font.u16(cmapOffset + 6) / 2;
+        size_t endCodes = cmapOffset + 14;
+        size_t startCodes = endCodes + 2 * static_cast<size_t>(segCount) + 2;
+        size_t idDeltas = startCodes + 2 * static_cast<size_t>(segCount);
+        size_t idRangeOffsets = idDeltas + 2 * static_cast<size_t>(segCount);
+
+        for (uint16_t s = 0; s < segCount; ++s) {
+            uint16_t endCode = font.u16(endCodes + 2 * static_cast<size_t>(s));
+            if (codePoint > endCode) continue;
+            uint16_t startCode = font.u16(startCodes + 2 * static_cast<size_t>(s));
+            if (codePoint < startCode) return 0;
+
+            uint16_t idDelta = font.u16(idDeltas + 2 * static_cast<size_t>(s));
+            size_t rangeOffsetPosition = idRangeOffsets + 2 * static_cast<size_t>(s);
+            uint16_t idRangeOffset = font.u16(rangeOffsetPosition);
+            if (idRangeOffset == 0) {
+                return static_cast<uint16_t>(codePoint + idDelta);
+            }
+            uint16_t glyph = font.u16(rangeOffsetPosition + idRangeOffset + 2 * (codePoint - startCode));
+            return glyph == 0 ? 0 : static_cast<uint16_t>(glyph + idDelta);
+        }
+    }
+    return 0;
+}
+
+int FontFace::advance(uint16_t glyph) const {
+    return glyph < advances.size() ? advances[glyph] : advances.back();
+}
+
+int FontFace::kerning(uint16_t left, uint16_t right) const {
+    auto it = kernPairs.find((static_cast<uint32_t>(left) << 16) | right);
+    return it == kernPairs.end() ? 0 : it->second;
+}
+
+// ------------------------------ ScaledFont ------------------------------ //
+ScaledFont::ScaledFont(std::shared_ptr<const FontFace> face, int fontHeight)
+    : fontFace(face), scale(static_cast<double>(fontHeight) / face->unitsPerEm()) {
+    for (uint32_t c = 0; c < 256; ++c) {
+        latinGlyph[c] = face->glyphIndex(c);
+        latinAdvance[c] = face->advance(latinGlyph[c]) * scale;
+    }
+}
+
+double ScaledFont::advancePx(uint32_t codePoint) const {
+    if (codePoint < 256) {
+        return latinAdvance[codePoint];
+    }
+    return fontFace->advance(fontFace->glyphIndex(codePoint)) * scale;
+}
+
+double ScaledFont::kerningPx(uint32_t left, uint32_t right) const {
+    uint16_t leftGlyph = left < 256 ? latinGlyph[left] : fontFace->glyphIndex(left);
+    uint16_t rightGlyph = right < 256 ? latinGlyph[right] : fontFace->glyphIndex(right);
+    // .notdef is never kerned
+    if (leftGlyph == 0 || rightGlyph == 0) return 0.0;
+    return fontFace->kerning(leftGlyph, rightGlyph) * scale;
+}
+
+int ScaledFont::textWidth(const std::wstring& text) const {
+    double width = 0.0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t codePoint = static_cast<uint32_t>(text[i]);
+        width += advancePx(codePoint);
+        if (i + 1 < text.size()) {
+            width += kerningPx(codePoint, static_cast<uint32_t>(text[i + 1]));
+        }
+    }
+    return static_cast<int>(std::lround(width));
+}
+
+// ------------------------------ Lookup and caches ------------------------------ //
+std::string fontKey(const std::string& fontName) {
+    return normalizedName(fontName);
+}
+
+std::string findFontFile(const std::string& fontName) {
+    return locateFont(fontName).path;
+}
+
+std::shared_ptr<const ScaledFont> scaledFont(const std::string& fontName, int fontHeight) {
+    // ---------- Process-wide caches: font name -> face (null = not available), (name, height) -> scaled tables ---------- //
+    static std::mutex cacheMutex;
+    static std::map<std::string, std::shared_ptr<const FontFace>> faces;
+    static std::map<std::pair<std::string, int>, std::shared_ptr<const ScaledFont>> scaled;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::string key = normalizedName(fontName);
+    auto scaledIt = scaled.find(std::make_pair(key, fontHeight));
+    if (scaledIt != scaled.end()) {
+        return scaledIt->second;
+    }
+
+    auto faceIt = faces.find(key);
+    if (faceIt == faces.end()) {
+        std::shared_ptr<const FontFace> face;
+        FontLocation location = locateFont(fontName);
+        if (location.path.empty()) {
+            WLOG_WARN(L"[FONT] [!] Font '" << widen(fontName) << L"' not found, using the 0.6 width estimate");
+        } else {
+            try {
+                face = FontFace::load(location.path, location.faceIndex);
+                WLOG_INFO(L"[FONT] [OK] " << widen(fontName) << L" -> " << widen(location.path));
+            } catch (const std::exception& e) {
+                std::string err = e.what();
+                WLOG_WARN(L"[FONT] [!] " << widen(err) << L", using the 0.6 width estimate");
+            }
+        }
+        faceIt = faces.emplace(key, face).first;
+    }
+
+    std::shared_ptr<const ScaledFont> result;
+    if (faceIt->second && fontHeight > 0) {
+        result = std::make_shared<ScaledFont>(faceIt->second, fontHeight);
+    }
+    scaled.emplace(std::make_pair(key, fontHeight), result);
+    return result;
+}
+
+int measureTextWidth(const std::wstring& text, const std::string& fontName, int fontHeight) {
+    int width = 0;
+    std::shared_ptr<const GlyphCache> cache = glyphCache();
+    if (cache && cache->textWidth(text, fontName, fontHeight, width)) {
+        return width;
+    }
+
+    std::shared_ptr<const ScaledFont> font = scaledFont(fontName, fontHeight);
+    if (font) {
+        return font->textWidth(text);
+    }
+    // Estimate character width: approximately 0.6 * font height for most monospace-ish fonts
+    double charWidthRatio = 0.6;
+    return static_cast<int>(text.length() * fontHeight * charWidthRatio);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ------------------------------ One face of a TrueType / OpenType (sfnt) font file ------------------------------ //
+// Only what text measuring needs: unitsPerEm, the cmap (formats 4 and 12), hmtx advances and kern format 0 pairs.
+// GPOS kerning is not read; fonts that only kern through GPOS measure without kerning.
+class FontFace {
+public:
+    // ---------- Parses face `faceIndex` (for .ttc collections) of `path`, throws std::runtime_error on bad input ---------- //
+    static std::shared_ptr<FontFace> load(const std::string& path, uint32_t faceIndex = 0);
+
+    uint16_t unitsPerEm() const { return emUnits; }
+    uint16_t glyphIndex(uint32_t codePoint) const;      // 0 (.notdef) when the font has no glyph
+    int advance(uint16_t glyph) const;                  // font units
+    int kerning(uint16_t left, uint16_t right) const;   // font units, usually negative
+    const std::string& path() const { return filePath; }
+
+private:
+    FontFace() = default;
+
+    std::string filePath;
+    std::vector<uint8_t> data;
+    uint16_t emUnits = 1000;
+    std::vector<uint16_t> advances;                      // one per hMetric, the last one repeats
+    uint32_t cmapOffset = 0;                             // chosen cmap subtable, 0 = none
+    uint16_t cmapFormat = 0;
+    std::unordered_map<uint32_t, int16_t> kernPairs;     // (left << 16) | right
+};
+
+// ------------------------------ Font scaled to one pixel height, with precomputed Latin-1 tables (cheap to create) ------------------------------ //
+// fontHeight is taken as the em size in pixels (the size HDSDK renders the glyphs at).
+class ScaledFont {
+public:
+    ScaledFont(std::shared_ptr<const FontFace> face, int fontHeight);
+
+    // ---------- Width of `text` in pixels: table lookups for Latin-1, cmap lookups for everything else ---------- //
+    int textWidth(const std::wstring& text) const;
+
+    const FontFace& face() const { return *fontFace; }
+
+private:
+    double advancePx(uint32_t codePoint) const;
+    double kerningPx(uint32_t left, uint32_t right) const;
+
+    std::shared_ptr<const FontFace> fontFace;
+    double scale = 0.0;
+    double latinAdvance[256] = {};
+    uint16_t latinGlyph[256] = {};                      // cmap resolved once; kerning is a single pair lookup
+};
+
+// ------------------------------ Lookup key of a FontName: lowercase, without spaces, dashes and underscores ------------------------------ //
+std::string fontKey(const std::string& fontName);
+
+// ------------------------------ Font file for a FontName; the name may also be a path to a .ttf/.otf/.ttc ------------------------------ //
+// Looks in the system and user font folders, first by file name ("Arial" -> arial.ttf), then by the
+// family / full names stored in the fonts. Returns an empty path if nothing matches.
+std::string findFontFile(const std::string& fontName);
+
+// ------------------------------ Cached ScaledFont per (font, height), null if the font cannot be found or read ------------------------------ //
+std::shared_ptr<const ScaledFont> scaledFont(const std::string& fontName, int fontHeight);
+
+// ------------------------------ Text width in pixels ------------------------------ //
+// Uses the mapped glyph cache when it covers the font, height and characters, else the parsed font,
+// else the 0.6 * height estimate.
+int measureTextWidth(const std::wstring& text, const std::string& fontName, int fontHeight);
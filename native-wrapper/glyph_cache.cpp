@@ -0,0 +1,526 @@
+#include "glyph_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include "font_metrics.hpp"
+#include "log.hpp"
+#include "utf8.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ------------------------------ File layout (native byte order, every section 8-byte aligned) ------------------------------ //
+//   FileHeader | FontRecord[fontCount] | EntryRecord[entryCount] | string pool | per entry: RangeRecord[], advances, KernRecord[]
+const char kMagic[4] = { 'N', 'G', 'C', '1' };
+const uint32_t kByteOrderMark = 0x01020304;
+const uint32_t kFormatVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t byteOrder;         // kByteOrderMark as written; a cache from a machine of the other endianness is rejected
+    uint32_t version;
+    uint32_t fontCount;
+    uint32_t entryCount;
+    uint32_t stringBytes;       // size of the NUL-terminated string pool after the entries
+    uint64_t fileSize;
+};
+
+struct FontRecord {
+    uint32_t nameOffset;        // fontKey() of the FontName, in the string pool
+    uint32_t pathOffset;        // font file the entries were built from
+    uint64_t fileSize;
+    int64_t mtime;              // filesystem clock ticks
+    uint64_t contentHash;       // FNV-1a of the whole font file
+};
+
+struct EntryRecord {
+    uint32_t fontIndex;
+    int32_t fontHeight;
+    uint32_t rangeOffset;       // byte offset of RangeRecord[rangeCount]
+    uint32_t rangeCount;
+    uint32_t kernOffset;        // byte offset of KernRecord[kernCount], sorted by (left, right)
+    uint32_t kernCount;
+    uint32_t reserved[2];
+};
+
+struct RangeRecord {
+    uint32_t first;
+    uint32_t last;
+    uint32_t advanceOffset;     // byte offset of double[last - first + 1], pixels
+    uint32_t reserved;
+};
+
+struct KernRecord {
+    uint32_t left;
+    uint32_t right;
+    double px;
+};
+
+static_assert(sizeof(FileHeader) == 32, "glyph cache header layout");
+static_assert(sizeof(FontRecord) == 32, "glyph cache font layout");
+static_assert(sizeof(EntryRecord) == 32, "glyph cache entry layout");
+static_assert(sizeof(RangeRecord) == 16, "glyph cache range layout");
+static_assert(sizeof(KernRecord) == 16, "glyph cache kerning layout");
+
+const uint32_t kNoEntry = UINT32_MAX;
+
+size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+bool kernLess(const KernRecord& record, std::pair<uint32_t, uint32_t> key) {
+    return record.left < key.first || (record.left == key.first && record.right < key.second);
+}
+
+// ---------- FNV-1a over the whole file ---------- //
+uint64_t hashFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open font file: " + path);
+    }
+    uint64_t hash = 1469598103934665603ULL;
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+int64_t fileMtime(const std::string& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+uint64_t fileSizeOf(const std::string& path) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+// ---------- Appends raw records to the file image ---------- //
+template <typename T>
+size_t appendRecords(std::vector<uint8_t>& image, const T* records, size_t count) {
+    size_t offset = align8(image.size());
+    image.resize(offset + sizeof(T) * count);
+    if (count > 0) {
+        memcpy(image.data() + offset, records, sizeof(T) * count);
+    }
+    return offset;
+}
+
+std::mutex globalCacheMutex;
+std::shared_ptr<const GlyphCache> globalCache;
+
+} // namespace
+
+// ------------------------------ Ranges ------------------------------ //
+const char* defaultGlyphRanges() {
+    return "ascii,latin1,latin-ext,cyrillic,currency";
+}
+
+std::vector<GlyphRange> parseGlyphRanges(const std::string& spec) {
+    std::vector<GlyphRange> ranges;
+    std::stringstream ss(spec);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty()) continue;
+        if (part == "ascii") ranges.push_back({ 0x20, 0x7E });
+        else if (part == "latin1") ranges.push_back({ 0xA0, 0xFF });
+        else if (part == "latin-ext") ranges.push_back({ 0x100, 0x17F });
+        else if (part == "cyrillic") ranges.push_back({ 0x400, 0x4FF });
+        else if (part == "currency") ranges.push_back({ 0x20A0, 0x20BF });
+        else {
+            size_t dash = part.find('-', 1);
+            try {
+                GlyphRange range;
+                range.first = static_cast<uint32_t>(std::stoul(part.substr(0, dash), nullptr, 0));
+                range.last = dash == std::string::npos ? range.first : static_cast<uint32_t>(std::stoul(part.substr(dash + 1), nullptr, 0));
+                if (range.last < range.first || range.last > 0x10FFFF) throw std::out_of_range(part);
+                ranges.push_back(range);
+            } catch (const std::logic_error&) {
+                throw std::runtime_error("Invalid glyph range: " + part);
+            }
+        }
+    }
+
+    // ---------- Sorted, overlapping / adjacent ranges merged ---------- //
+    std::sort(ranges.begin(), ranges.end(), [](const GlyphRange& a, const GlyphRange& b) { return a.first < b.first; });
+    std::vector<GlyphRange> merged;
+    for (const GlyphRange& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().last + 1) {
+            merged.back().last = std::max(merged.back().last, range.last);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    if (merged.empty()) {
+        throw std::runtime_error("No glyph ranges given");
+    }
+    return merged;
+}
+
+// ------------------------------ Cache builder ------------------------------ //
+void writeGlyphCache(const std::string& path, const std::vector<GlyphCacheFont>& fonts, const std::vector<GlyphRange>& ranges) {
+    std::vector<FontRecord> fontRecords;
+    std::vector<EntryRecord> entryRecords;
+    std::string strings;
+
+    // ---------- Per entry data is built first, then placed after the fixed sections ---------- //
+    struct EntryData {
+        std::vector<RangeRecord> ranges;
+        std::vector<std::vector<double>> advances;
+        std::vector<KernRecord> kerning;
+    };
+    std::vector<EntryData> entryData;
+
+    for (const GlyphCacheFont& cacheFont : fonts) {
+        std::shared_ptr<const ScaledFont> probe = scaledFont(cacheFont.fontName, 1);
+        if (!probe) {
+            throw std::runtime_error("Font '" + cacheFont.fontName + "' not found or unreadable");
+        }
+        const FontFace& face = probe->face();
+
+        FontRecord fontRecord = {};
+        fontRecord.nameOffset = static_cast<uint32_t>(strings.size());
+        strings += fontKey(cacheFont.fontName) + '\0';
+        fontRecord.pathOffset = static_cast<uint32_t>(strings.size());
+        strings += face.path() + '\0';
+        fontRecord.fileSize = fileSizeOf(face.path());
+        fontRecord.mtime = fileMtime(face.path());
+        fontRecord.contentHash = hashFile(face.path());
+        fontRecords.push_back(fontRecord);
+
+        // ---------- Glyph IDs once per font; glyph 0 (.notdef) is never kerned, like ScaledFont ---------- //
+        std::vector<uint32_t> codePoints;
+        for (const GlyphRange& range : ranges) {
+            for (uint32_t c = range.first; c <= range.last; ++c) codePoints.push_back(c);
+        }
+        std::vector<uint16_t> glyphs(codePoints.size());
+        for (size_t i = 0; i < codePoints.size(); ++i) glyphs[i] = face.glyphIndex(codePoints[i]);
+
+        for (int fontHeight : cacheFont.fontHeights) {
+            if (fontHeight <= 0) continue;
+            // Same expressions as ScaledFont, so cached and parsed widths are bit-identical
+            double scale = static_cast<double>(fontHeight) / face.unitsPerEm();
+
+            EntryData data;
+            size_t index = 0;
+            for (const GlyphRange& range : ranges) {
+                data.ranges.push_back({ range.first, range.last, 0, 0 });
+                std::vector<double> advances;
+                for (uint32_t c = range.first; c <= range.last; ++c, ++index) {
+                    advances.push_back(face.advance(glyphs[index]) * scale);
+                }
+                data.advances.push_back(advances);
+            }
+            for (size_t l = 0; l < codePoints.size(); ++l) {
+                if (glyphs[l] == 0) continue;
+                for (size_t r = 0; r < codePoints.size(); ++r) {
+                    if (glyphs[r] == 0) continue;
+                    int kern = face.kerning(glyphs[l], glyphs[r]);
+                    if (kern != 0) {
+                        data.kerning.push_back({ codePoints[l], codePoints[r], kern * scale });
+                    }
+                }
+            }
+
+            EntryRecord entry = {};
+            entry.fontIndex = static_cast<uint32_t>(fontRecords.size() - 1);
+            entry.fontHeight = fontHeight;
+            entryRecords.push_back(entry);
+            entryData.push_back(data);
+        }
+    }
+
+    // ---------- File image ---------- //
+    std::vector<uint8_t> image(sizeof(FileHeader));
+    appendRecords(image, fontRecords.data(), fontRecords.size());
+    size_t entriesOffset = appendRecords(image, entryRecords.data(), entryRecords.size());
+    appendRecords(image, strings.data(), strings.size());
+
+    for (size_t e = 0; e < entryRecords.size(); ++e) {
+        EntryData& data = entryData[e];
+        for (size_t r = 0; r < data.ranges.size(); ++r) {
+            data.ranges[r].advanceOffset = static_cast<uint32_t>(appendRecords(image, data.advances[r].data(), data.advances[r].size()));
+        }
+        entryRecords[e].rangeOffset = static_cast<uint32_t>(appendRecords(image, data.ranges.data(), data.ranges.size()));
+        entryRecords[e].rangeCount = static_cast<uint32_t>(data.ranges.size());
+        entryRecords[e].kernOffset = static_cast<uint32_t>(appendRecords(image, data.kerning.data(), data.kerning.size()));
+        entryRecords[e].kernCount = static_cast<uint32_t>(data.kerning.size());
+    }
+    image.resize(align8(image.size()));
+    if (image.size() > UINT32_MAX) {
+        throw std::runtime_error("Glyph cache too large; use fewer fonts, heights or ranges");
+    }
+
+    if (!entryRecords.empty()) {
+        memcpy(image.data() + entriesOffset, entryRecords.data(), sizeof(EntryRecord) * entryRecords.size());
+    }
+    FileHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.byteOrder = kByteOrderMark;
+    header.version = kFormatVersion;
+    header.fontCount = static_cast<uint32_t>(fontRecords.size());
+    header.entryCount = static_cast<uint32_t>(entryRecords.size());
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+    header.fileSize = image.size();
+    memcpy(image.data(), &header, sizeof(header));
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot write glyph cache: " + tempPath);
+        }
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!file) {
+            throw std::runtime_error("Cannot write glyph cache: " + tempPath);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace glyph cache: " + path);
+    }
+}
+
+// ------------------------------ Mapped cache ------------------------------ //
+std::shared_ptr<GlyphCache> GlyphCache::open(const std::string& path) {
+    std::shared_ptr<GlyphCache> cache(new GlyphCache());
+    cache->filePath = path;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open glyph cache: " + path);
+    }
+    cache->fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+        throw std::runtime_error("Glyph cache too small: " + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        throw std::runtime_error("Failed to map glyph cache: " + path);
+    }
+    cache->mappingHandle = mapping;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        throw std::runtime_error("Failed to map glyph cache: " + path);
+    }
+    cache->data = static_cast<const uint8_t*>(view);
+    cache->size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open glyph cache: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("Glyph cache too small: " + path);
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Failed to map glyph cache: " + path);
+    }
+    cache->data = static_cast<const uint8_t*>(view);
+    cache->size = static_cast<size_t>(info.st_size);
+#endif
+
+    // ---------- Validate once, so lookups can index without checks ---------- //
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(cache->data);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a glyph cache file: " + path);
+    }
+    if (header->byteOrder != kByteOrderMark || header->version != kFormatVersion) {
+        throw std::runtime_error("Glyph cache was built for another platform or version, rebuild it: " + path);
+    }
+    if (header->fileSize != cache->size) {
+        throw std::runtime_error("Glyph cache truncated: " + path);
+    }
+
+    auto inBounds = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset <= cache->size && bytes <= cache->size - offset;
+    };
+    size_t fontsOffset = sizeof(FileHeader);
+    size_t entriesOffset = align8(fontsOffset + sizeof(FontRecord) * static_cast<uint64_t>(header->fontCount));
+    size_t stringsOffset = align8(entriesOffset + sizeof(EntryRecord) * static_cast<uint64_t>(header->entryCount));
+    if (!inBounds(entriesOffset, 0) || !inBounds(stringsOffset, header->stringBytes) ||
+        (header->stringBytes > 0 && cache->data[stringsOffset + header->stringBytes - 1] != '\0')) {
+        throw std::runtime_error("Glyph cache corrupt (tables): " + path);
+    }
+
+    const FontRecord* fonts = reinterpret_cast<const FontRecord*>(cache->data + fontsOffset);
+    for (uint32_t f = 0; f < header->fontCount; ++f) {
+        if (fonts[f].nameOffset >= header->stringBytes || fonts[f].pathOffset >= header->stringBytes) {
+            throw std::runtime_error("Glyph cache corrupt (font names): " + path);
+        }
+    }
+    const EntryRecord* entries = reinterpret_cast<const EntryRecord*>(cache->data + entriesOffset);
+    for (uint32_t e = 0; e < header->entryCount; ++e) {
+        const EntryRecord& entry = entries[e];
+        if (entry.fontIndex >= header->fontCount ||
+            !inBounds(entry.rangeOffset, sizeof(RangeRecord) * static_cast<uint64_t>(entry.rangeCount)) ||
+            !inBounds(entry.kernOffset, sizeof(KernRecord) * static_cast<uint64_t>(entry.kernCount))) {
+            throw std::runtime_error("Glyph cache corrupt (entries): " + path);
+        }
+        const RangeRecord* ranges = reinterpret_cast<const RangeRecord*>(cache->data + entry.rangeOffset);
+        for (uint32_t r = 0; r < entry.rangeCount; ++r) {
+            if (ranges[r].last < ranges[r].first ||
+                !inBounds(ranges[r].advanceOffset, sizeof(double) * (static_cast<uint64_t>(ranges[r].last - ranges[r].first) + 1))) {
+                throw std::runtime_error("Glyph cache corrupt (ranges): " + path);
+            }
+        }
+    }
+
+    // ---------- Font files: a cheap stat, the content hash only when size or mtime moved ---------- //
+    const char* strings = reinterpret_cast<const char*>(cache->data + stringsOffset);
+    cache->fontStale.assign(header->fontCount, false);
+    for (uint32_t f = 0; f < header->fontCount; ++f) {
+        std::string fontPath = strings + fonts[f].pathOffset;
+        if (fileSizeOf(fontPath) == fonts[f].fileSize && fileMtime(fontPath) == fonts[f].mtime) {
+            continue;
+        }
+        uint64_t contentHash = 0;
+        try {
+            contentHash = hashFile(fontPath);
+        } catch (const std::exception&) {
+            contentHash = 0;
+        }
+        if (contentHash != fonts[f].contentHash) {
+            cache->fontStale[f] = true;
+            WLOG_WARN(L"[FONT] [!] Glyph cache is stale for " << widen(fontPath)
+                      << L" (font file changed), measuring from the font file");
+        }
+    }
+
+    // ---------- Index by (font key, height); the first entry of a duplicate wins, as in file order ---------- //
+    for (uint32_t e = 0; e < header->entryCount; ++e) {
+        if (entries[e].fontHeight <= 0) continue;
+        std::vector<uint32_t>& byHeight = cache->entriesByFont[strings + fonts[entries[e].fontIndex].nameOffset];
+        size_t height = static_cast<size_t>(entries[e].fontHeight);
+        if (byHeight.size() <= height) byHeight.resize(height + 1, kNoEntry);
+        if (byHeight[height] == kNoEntry) byHeight[height] = e;
+    }
+    return cache;
+}
+
+GlyphCache::~GlyphCache() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+}
+
+uint32_t GlyphCache::entryCount() const {
+    return reinterpret_cast<const FileHeader*>(data)->entryCount;
+}
+
+bool GlyphCache::textWidth(const std::wstring& text, const std::string& fontName, int fontHeight, int& width) const {
+    auto font = entriesByFont.find(fontKey(fontName));
+    if (font == entriesByFont.end() || fontHeight <= 0 || static_cast<size_t>(fontHeight) >= font->second.size()) {
+        return false;
+    }
+    uint32_t entryIndex = font->second[static_cast<size_t>(fontHeight)];
+    if (entryIndex == kNoEntry) {
+        return false;
+    }
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+    size_t entriesOffset = align8(sizeof(FileHeader) + sizeof(FontRecord) * header->fontCount);
+    const EntryRecord* entry = reinterpret_cast<const EntryRecord*>(data + entriesOffset) + entryIndex;
+    if (fontStale[entry->fontIndex]) {
+        return false;
+    }
+
+    const RangeRecord* ranges = reinterpret_cast<const RangeRecord*>(data + entry->rangeOffset);
+    const KernRecord* kernBegin = reinterpret_cast<const KernRecord*>(data + entry->kernOffset);
+    const KernRecord* kernEnd = kernBegin + entry->kernCount;
+
+    // ---------- Same summation order as ScaledFont::textWidth ---------- //
+    double total = 0.0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t codePoint = static_cast<uint32_t>(text[i]);
+        const RangeRecord* range = nullptr;
+        for (uint32_t r = 0; r < entry->rangeCount && !range; ++r) {
+            if (codePoint >= ranges[r].first && codePoint <= ranges[r].last) range = &ranges[r];
+        }
+        if (!range) {
+            return false;
+        }
+        total += reinterpret_cast<const double*>(data + range->advanceOffset)[codePoint - range->first];
+
+        if (i + 1 < text.size()) {
+            std::pair<uint32_t, uint32_t> pair(codePoint, static_cast<uint32_t>(text[i + 1]));
+            const KernRecord* it = std::lower_bound(kernBegin, kernEnd, pair, kernLess);
+            if (it != kernEnd && it->left == pair.first && it->right == pair.second) {
+                total += it->px;
+            }
+        }
+    }
+    width = static_cast<int>(std::lround(total));
+    return true;
+}
+
+std::wstring GlyphCache::describe() const {
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+    const FontRecord* fonts = reinterpret_cast<const FontRecord*>(data + sizeof(FileHeader));
+    size_t entriesOffset = align8(sizeof(FileHeader) + sizeof(FontRecord) * header->fontCount);
+    const EntryRecord* entries = reinterpret_cast<const EntryRecord*>(data + entriesOffset);
+    const char* strings = reinterpret_cast<const char*>(data + align8(entriesOffset + sizeof(EntryRecord) * header->entryCount));
+
+    std::wstringstream out;
+    out << L"Glyph cache " << widen(filePath) << L": " << header->fontCount << L" font(s), "
+        << header->entryCount << L" entries, " << size << L" bytes\n";
+    for (uint32_t f = 0; f < header->fontCount; ++f) {
+        out << L"  " << widen(strings + fonts[f].nameOffset) << L" -> " << widen(strings + fonts[f].pathOffset)
+            << L" (" << fonts[f].fileSize << L" bytes, hash " << std::hex << fonts[f].contentHash << std::dec << L")\n";
+        for (uint32_t e = 0; e < header->entryCount; ++e) {
+            if (entries[e].fontIndex != f) continue;
+            const RangeRecord* ranges = reinterpret_cast<const RangeRecord*>(data + entries[e].rangeOffset);
+            out << L"    height " << entries[e].fontHeight << L": ";
+            for (uint32_t r = 0; r < entries[e].rangeCount; ++r) {
+                out << (r ? L"," : L"") << std::hex << L"U+" << ranges[r].first << L"-U+" << ranges[r].last << std::dec;
+            }
+            out << L", " << entries[e].kernCount << L" kerning pairs\n";
+        }
+    }
+    return out.str();
+}
+
+// ------------------------------ Process-wide cache ------------------------------ //
+void setGlyphCache(std::shared_ptr<const GlyphCache> cache) {
+    std::lock_guard<std::mutex> lock(globalCacheMutex);
+    globalCache = cache;
+}
+
+std::shared_ptr<const GlyphCache> glyphCache() {
+    std::lock_guard<std::mutex> lock(globalCacheMutex);
+    return globalCache;
+}
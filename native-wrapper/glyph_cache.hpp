@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ------------------------------ Precompiled glyph advance cache (glyph-cache.bin) ------------------------------ //
+// Built offline by glyph_cache_tool from the installed fonts; the wrapper maps the file read-only at startup and
+// measures text with table lookups, without locating or parsing any font. One entry per (font name, pixel height)
+// holds advances for a set of code point ranges and the kerning pairs between them, already scaled to pixels,
+// so widths come out exactly as ScaledFont::textWidth computes them.
+//
+// Each font records its file's size, mtime and FNV-1a content hash. Opening the cache stats every font file; only
+// if size or mtime changed is the file hashed, and a different hash marks the font stale (measured from the font
+// file instead until the cache is rebuilt). After that a lookup is two table indexes and no lock.
+
+// ---------- Code point range, inclusive ---------- //
+struct GlyphRange {
+    uint32_t first = 0;
+    uint32_t last = 0;
+};
+
+// ---------- "ascii,latin1,latin-ext,cyrillic,currency" or explicit "0x20-0x7E"; throws std::runtime_error ---------- //
+std::vector<GlyphRange> parseGlyphRanges(const std::string& spec);
+
+// ---------- Default ranges: ASCII, Latin-1, Latin Extended-A (č ć š ž đ), Cyrillic, currency symbols ---------- //
+const char* defaultGlyphRanges();
+
+// ---------- One font of the cache and the pixel heights to precompute ---------- //
+struct GlyphCacheFont {
+    std::string fontName;        // as written in the INI FontName (or a font file path)
+    std::vector<int> fontHeights;
+};
+
+// ------------------------------ Builds a cache file (temp file + rename); throws std::runtime_error ------------------------------ //
+void writeGlyphCache(const std::string& path, const std::vector<GlyphCacheFont>& fonts, const std::vector<GlyphRange>& ranges);
+
+// ------------------------------ Read-only mapped cache file ------------------------------ //
+class GlyphCache {
+public:
+    // ---------- Maps `path`, validates the header, every offset and every font file once; throws std::runtime_error ---------- //
+    static std::shared_ptr<GlyphCache> open(const std::string& path);
+    ~GlyphCache();
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    // ---------- Width of `text` in pixels; false if the font/height is not cached, is stale, or a character is outside the ranges ---------- //
+    bool textWidth(const std::wstring& text, const std::string& fontName, int fontHeight, int& width) const;
+
+    const std::string& path() const { return filePath; }
+    uint32_t entryCount() const;
+
+    // ---------- Human-readable listing of fonts, heights and ranges (glyph_cache_tool --dump) ---------- //
+    std::wstring describe() const;
+
+private:
+    GlyphCache() = default;
+
+    std::string filePath;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    std::unordered_map<std::string, std::vector<uint32_t>> entriesByFont;  // fontKey -> entry index by height, kNoEntry if not cached
+    std::vector<bool> fontStale;        // per font record: its file no longer matches the cached widths
+};
+
+// ------------------------------ Process-wide cache used by measureTextWidth (null = none) ------------------------------ //
+void setGlyphCache(std::shared_ptr<const GlyphCache> cache);
+std::shared_ptr<const GlyphCache> glyphCache();
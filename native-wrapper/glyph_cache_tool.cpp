@@ -0,0 +1,114 @@
+// ------------------------------ glyph_cache_tool - builds / inspects glyph-cache.bin for dll_wrapper ------------------------------ //
+//   glyph_cache_tool --out=glyph-cache.bin --font="Arial:24,32,48" --font="Arial Black:32" [--ranges=ascii,cyrillic,0x20AC]
+//   glyph_cache_tool --dump=glyph-cache.bin
+// dll_wrapper maps glyph-cache.bin from its own folder (or --glyph-cache=<file>) at startup.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "glyph_cache.hpp"
+#include "log.hpp"
+#include "utf8.hpp"
+
+#ifndef _WIN32
+#include <clocale>
+#endif
+
+namespace {
+
+// ---------- "Arial:24,32,48" -> font + heights ---------- //
+GlyphCacheFont parseFontArgument(const std::string& value) {
+    size_t colon = value.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        throw std::runtime_error("Expected --font=<name>:<height>[,<height>...], got: " + value);
+    }
+    GlyphCacheFont font;
+    font.fontName = value.substr(0, colon);
+    std::stringstream ss(value.substr(colon + 1));
+    std::string height;
+    while (std::getline(ss, height, ',')) {
+        int h = std::atoi(height.c_str());
+        if (h <= 0) {
+            throw std::runtime_error("Invalid font height '" + height + "' for " + font.fontName);
+        }
+        font.fontHeights.push_back(h);
+    }
+    if (font.fontHeights.empty()) {
+        throw std::runtime_error("No font heights given for " + font.fontName);
+    }
+    return font;
+}
+
+void printUsage() {
+    std::wcout << L"Usage:\n"
+               << L"  glyph_cache_tool --out=<glyph-cache.bin> --font=<FontName>:<h>[,<h>...] [--font=...] [--ranges=<list>]\n"
+               << L"  glyph_cache_tool --dump=<glyph-cache.bin>\n"
+               << L"Ranges: ascii, latin1, latin-ext, cyrillic, currency or 0xFIRST-0xLAST (default: "
+               << defaultGlyphRanges() << L")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+#ifndef _WIN32
+    if (!std::setlocale(LC_ALL, "C.UTF-8")) {
+        std::setlocale(LC_ALL, "");
+    }
+#endif
+    // Font lookups log to stderr through the wrapper's buffered log
+    std::atexit(flushLog);
+
+    std::string outPath;
+    std::string dumpPath;
+    std::string rangeSpec = defaultGlyphRanges();
+    std::vector<GlyphCacheFont> fonts;
+
+    try {
+        for (int a = 1; a < argc; ++a) {
+            std::string arg = argv[a];
+            if (arg.rfind("--out=", 0) == 0) {
+                outPath = arg.substr(6);
+            } else if (arg.rfind("--dump=", 0) == 0) {
+                dumpPath = arg.substr(7);
+            } else if (arg.rfind("--ranges=", 0) == 0) {
+                rangeSpec = arg.substr(9);
+            } else if (arg.rfind("--font=", 0) == 0) {
+                fonts.push_back(parseFontArgument(arg.substr(7)));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        // ------------------------------ Dump: map the file the way the wrapper does ------------------------------ //
+        if (!dumpPath.empty()) {
+            auto startTime = std::chrono::steady_clock::now();
+            std::shared_ptr<GlyphCache> cache = GlyphCache::open(dumpPath);
+            auto openUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+            flushLog();
+            std::wcout << cache->describe() << L"Mapped and validated in " << openUs << L" us" << std::endl;
+            return 0;
+        }
+
+        if (outPath.empty() || fonts.empty()) {
+            printUsage();
+            return 2;
+        }
+
+        // ------------------------------ Build ------------------------------ //
+        std::vector<GlyphRange> ranges = parseGlyphRanges(rangeSpec);
+        writeGlyphCache(outPath, fonts, ranges);
+        std::shared_ptr<GlyphCache> cache = GlyphCache::open(outPath);
+        flushLog();
+        std::wcout << L"[CACHE] [OK] Written\n" << cache->describe() << std::flush;
+        return 0;
+    } catch (const std::exception& e) {
+        std::string err = e.what();
+        WLOG_ERROR(L"[CACHE] [X] " << widen(err));
+        return 1;
+    }
+}
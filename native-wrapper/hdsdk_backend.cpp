@@ -0,0 +1,218 @@
+#include "display_backend.hpp"
+
+#include <stdexcept>
+#include <string>
+#include "flight_recorder.hpp"
+#include "log.hpp"
+#include "perf_trace.hpp"
+#include "utf8.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#define HD_API __stdcall
+#else
+#include <dlfcn.h>
+#define HD_API
+#endif
+
+// ------------------------------ Typedefs for SDK function pointers - loaded dynamically ------------------------------ //
+typedef int (HD_API *HD_GetSDKLastError)();
+typedef int (HD_API *HD_CreateScreen)(int, int, int, int, int, void*, int);
+typedef int (HD_API *HD_AddProgram)(void*, int, int, void*, int);
+typedef int (HD_API *HD_AddArea)(int, int, int, int, int, void*, int, int, void*, int);
+typedef int (HD_API *HD_AddSimpleTextAreaItem)(int, void*, int, int, int, void*, int, int, int, int, int, void*, int);
+typedef int (HD_API *HD_SendScreen)(int, void*, void*, void*, int);
+typedef int (HD_API *HD_Cmd_AdjustTime)(int, void*, void*);
+
+// ------------------------------ Thin portable shared library handle ------------------------------ //
+namespace {
+
+#ifdef _WIN32
+typedef HMODULE LibraryHandle;
+const char* kDefaultSdkLibrary = "HDSdk.dll";
+
+LibraryHandle openLibrary(const std::string& path) {
+    std::wstring path_ws = widen(path);
+    return LoadLibraryW(path_ws.c_str());
+}
+void* findSymbol(LibraryHandle handle, const char* symbol) {
+    return reinterpret_cast<void*>(GetProcAddress(handle, symbol));
+}
+void closeLibrary(LibraryHandle handle) {
+    FreeLibrary(handle);
+}
+#else
+typedef void* LibraryHandle;
+const char* kDefaultSdkLibrary = "libHDSDK.so";
+
+LibraryHandle openLibrary(const std::string& path) {
+    return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+void* findSymbol(LibraryHandle handle, const char* symbol) {
+    return dlsym(handle, symbol);
+}
+void closeLibrary(LibraryHandle handle) {
+    dlclose(handle);
+}
+#endif
+
+// ---------- The SDK takes UTF-16 strings; wchar_t is UTF-16 on Windows but UTF-32 elsewhere ---------- //
+// `buffer` belongs to the backend and keeps its capacity from call to call; on Windows it is not needed at all.
+#ifdef _WIN32
+typedef std::wstring SdkString;
+const SdkString& toSdkString(const std::wstring& s, SdkString&) { return s; }
+#else
+typedef std::u16string SdkString;
+const SdkString& toSdkString(const std::wstring& s, SdkString& buffer) {
+    buffer.clear();
+    for (wchar_t wc : s) {
+        char32_t cp = static_cast<char32_t>(wc);
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            buffer.push_back(static_cast<char16_t>(0xD800 + (cp >> 10)));
+            buffer.push_back(static_cast<char16_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            buffer.push_back(static_cast<char16_t>(cp));
+        }
+    }
+    return buffer;
+}
+#endif
+
+// ---------- Every SDK call is in the flight recorder before it is made, so a crash inside it is the last event ---------- //
+template <typename Call>
+int recordedSdkCall(const char* name, const char* detail, std::initializer_list<int32_t> args, Call&& call) {
+    recordFlightEvent(FlightEventKind::SdkCall, name, detail, 0, -1, args);
+    int value = call();
+    recordFlightEvent(FlightEventKind::SdkReturn, name, "", value);
+    return value;
+}
+
+// ------------------------------ Backend bound to the real HDSDK library ------------------------------ //
+class HdSdkBackend : public IDisplayBackend {
+public:
+    ~HdSdkBackend() override {
+        if (hLibrary) {
+            closeLibrary(hLibrary);
+        }
+    }
+
+    std::wstring name() const override { return L"hdsdk"; }
+
+    int createScreen(int width, int height, int cardType) override {
+        return recordedSdkCall("Hd_CreateScreen", "", { width, height, cardType }, [&]() {
+            return Hd_CreateScreen_ptr(width, height, 0, 1, cardType, nullptr, 0);
+        });
+    }
+
+    int addProgram() override {
+        return recordedSdkCall("Hd_AddProgram", "", {}, [&]() { return Hd_AddProgram_ptr(nullptr, 0, 0, nullptr, 0); });
+    }
+
+    int addArea(int programId, int x, int y, int width, int height) override {
+        return recordedSdkCall("Hd_AddArea", "", { x, y, width, height }, [&]() {
+            return Hd_AddArea_ptr(programId, x, y, width, height, nullptr, 0, 5, nullptr, 0);
+        });
+    }
+
+    int addText(int areaId, const std::wstring& text, int x, const std::wstring& fontName, int fontHeight) override {
+        const SdkString& text_sdk = toSdkString(text, textBuffer);
+        const SdkString& fontName_sdk = toSdkString(fontName, fontNameBuffer);
+        std::string text_utf8 = flightRecorderEnabled() ? wideToUtf8(text) : std::string();
+        return recordedSdkCall("Hd_AddSimpleTextAreaItem", text_utf8.c_str(), { areaId, x, fontHeight }, [&]() {
+            return Hd_AddSimpleTextAreaItem_ptr(
+                areaId, (void*)text_sdk.c_str(), 255, x, 0x0004,
+                (void*)fontName_sdk.c_str(), fontHeight, 0, 25, 0, 65535, nullptr, 0);
+        });
+    }
+
+    int sendScreen(const std::wstring& ipAddress) override {
+        const SdkString& ip_sdk = toSdkString(ipAddress, ipAddressBuffer);
+        std::string ip_utf8 = flightRecorderEnabled() ? wideToUtf8(ipAddress) : std::string();
+        return recordedSdkCall("Hd_SendScreen", ip_utf8.c_str(), {}, [&]() {
+            return Hd_SendScreen_ptr(0, (void*)ip_sdk.c_str(), nullptr, nullptr, 0);
+        });
+    }
+
+    bool supportsAdjustTime() const override { return Cmd_AdjustTime_ptr != nullptr; }
+
+    int adjustTime(const std::wstring& ipAddress) override {
+        const SdkString& ip_sdk = toSdkString(ipAddress, ipAddressBuffer);
+        std::string ip_utf8 = flightRecorderEnabled() ? wideToUtf8(ipAddress) : std::string();
+        return recordedSdkCall("Cmd_AdjustTime", ip_utf8.c_str(), {}, [&]() {
+            return Cmd_AdjustTime_ptr(0, (void*)ip_sdk.c_str(), nullptr);
+        });
+    }
+
+    int lastError() override {
+        return recordedSdkCall("Hd_GetSDKLastError", "", {}, [&]() { return Hd_GetSDKLastError_ptr(); });
+    }
+
+    LibraryHandle hLibrary = nullptr;
+    HD_GetSDKLastError Hd_GetSDKLastError_ptr = nullptr;
+    HD_CreateScreen Hd_CreateScreen_ptr = nullptr;
+    HD_AddProgram Hd_AddProgram_ptr = nullptr;
+    HD_AddArea Hd_AddArea_ptr = nullptr;
+    HD_AddSimpleTextAreaItem Hd_AddSimpleTextAreaItem_ptr = nullptr;
+    HD_SendScreen Hd_SendScreen_ptr = nullptr;
+    HD_Cmd_AdjustTime Cmd_AdjustTime_ptr = nullptr;
+
+private:
+    // ---------- UTF-16 copies of the call arguments; one backend makes one SDK call at a time ---------- //
+    SdkString textBuffer;
+    SdkString fontNameBuffer;
+    SdkString ipAddressBuffer;
+};
+
+} // namespace
+
+// ------------------------------ Loads the SDK library and resolves function pointers ------------------------------ //
+std::unique_ptr<IDisplayBackend> loadHdSdkBackend(const std::string& libraryPath) {
+    std::string path = libraryPath.empty() ? kDefaultSdkLibrary : libraryPath;
+    std::wstring path_ws = widen(path);
+
+    WLOG_INFO(L"[DLL] Loading " << path_ws << L"...");
+    std::unique_ptr<HdSdkBackend> backend(new HdSdkBackend());
+    TraceSpan loadSpan("LoadLibraryW", "sdk");
+    recordFlightEvent(FlightEventKind::Phase, "LoadLibrary", path.c_str());
+    backend->hLibrary = openLibrary(path);
+    loadSpan.end();
+    if (!backend->hLibrary) { throw std::runtime_error("Failed to load " + path); }
+    WLOG_INFO(L"[DLL] [OK] " << path_ws << L" loaded successfully");
+
+    // ---------- Retrieve function addresses from the library ---------- //
+    WLOG_INFO(L"[DLL] Resolving function pointers...");
+    TraceSpan resolveSpan("resolveSymbols", "sdk");
+    LibraryHandle hLib = backend->hLibrary;
+    backend->Hd_GetSDKLastError_ptr = (HD_GetSDKLastError)findSymbol(hLib, "Hd_GetSDKLastError");
+    backend->Hd_CreateScreen_ptr = (HD_CreateScreen)findSymbol(hLib, "Hd_CreateScreen");
+    backend->Hd_AddProgram_ptr = (HD_AddProgram)findSymbol(hLib, "Hd_AddProgram");
+    backend->Hd_AddArea_ptr = (HD_AddArea)findSymbol(hLib, "Hd_AddArea");
+    backend->Hd_AddSimpleTextAreaItem_ptr = (HD_AddSimpleTextAreaItem)findSymbol(hLib, "Hd_AddSimpleTextAreaItem");
+    backend->Hd_SendScreen_ptr = (HD_SendScreen)findSymbol(hLib, "Hd_SendScreen");
+    backend->Cmd_AdjustTime_ptr = (HD_Cmd_AdjustTime)findSymbol(hLib, "Cmd_AdjustTime");
+    resolveSpan.end();
+
+    // ---------- Ensure all required functions were found ---------- //
+    if (!backend->Hd_GetSDKLastError_ptr || !backend->Hd_CreateScreen_ptr || !backend->Hd_AddProgram_ptr ||
+        !backend->Hd_AddArea_ptr || !backend->Hd_AddSimpleTextAreaItem_ptr || !backend->Hd_SendScreen_ptr) {
+        throw std::runtime_error("Failed to get one or more required function pointers.");
+    }
+
+    WLOG_INFO(L"[DLL] [OK] Required functions resolved:");
+    WLOG_INFO(L"      - Hd_GetSDKLastError");
+    WLOG_INFO(L"      - Hd_CreateScreen");
+    WLOG_INFO(L"      - Hd_AddProgram");
+    WLOG_INFO(L"      - Hd_AddArea");
+    WLOG_INFO(L"      - Hd_AddSimpleTextAreaItem");
+    WLOG_INFO(L"      - Hd_SendScreen");
+
+    // ---------- Check optional function pointers ---------- //
+    if (!backend->Cmd_AdjustTime_ptr) {
+        WLOG_WARN(L"[DLL] [!] Optional function Cmd_AdjustTime not available (time adjustment disabled)");
+    } else {
+        WLOG_INFO(L"[DLL] [OK] Optional function Cmd_AdjustTime available");
+    }
+
+    return backend;
+}
@@ -0,0 +1,278 @@
+#include "health_cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include "json.hpp"
+#include "log.hpp"
+#include "utf8.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+int64_t nowUnixMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* stateName(ControllerHealth::State state) {
+    switch (state) {
+        case ControllerHealth::State::Open: return "open";
+        case ControllerHealth::State::HalfOpen: return "half-open";
+        case ControllerHealth::State::Closed:
+        default: return "closed";
+    }
+}
+
+ControllerHealth::State parseState(const std::string& name) {
+    if (name == "open") return ControllerHealth::State::Open;
+    if (name == "half-open") return ControllerHealth::State::HalfOpen;
+    return ControllerHealth::State::Closed;
+}
+
+} // namespace
+
+ControllerHealthCache::ControllerHealthCache(const std::string& path, HealthPolicy policy)
+    : path(path), policy(policy) {
+    load();
+}
+
+bool ControllerHealthCache::allowAttempt(const std::string& ip) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = controllers.find(ip);
+    if (it == controllers.end()) {
+        return true;
+    }
+
+    ControllerHealth& health = it->second;
+    switch (health.state) {
+        case ControllerHealth::State::Closed:
+            return true;
+        case ControllerHealth::State::Open:
+            if (nowUnixMs() < health.openUntil) {
+                return false;
+            }
+            health.state = ControllerHealth::State::HalfOpen;
+            health.probeInFlight = false;
+            dirty = true;
+            // The first caller after the cool-down becomes the probe
+            [[fallthrough]];
+        case ControllerHealth::State::HalfOpen:
+        default:
+            if (health.probeInFlight) {
+                return false;
+            }
+            health.probeInFlight = true;
+            return true;
+    }
+}
+
+void ControllerHealthCache::recordOutcome(const std::string& ip, bool success, int errorCode, double latencyMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ControllerHealth& health = controllers[ip];
+    int64_t now = nowUnixMs();
+
+    health.ewmaLatencyMs = health.recentCount == 0
+        ? latencyMs
+        : policy.latencyAlpha * latencyMs + (1.0 - policy.latencyAlpha) * health.ewmaLatencyMs;
+    health.recentOutcomes = (health.recentOutcomes << 1) | (success ? 1u : 0u);
+    health.recentCount = std::min<uint32_t>(health.recentCount + 1, 32);
+    health.probeInFlight = false;
+    dirty = true;
+
+    if (!success) {
+        // The controller may have been power-cycled; don't trust what we think it shows
+        health.contentHash = 0;
+    }
+
+    if (success) {
+        health.state = ControllerHealth::State::Closed;
+        health.consecutiveFailures = 0;
+        health.cooldownMs = 0;
+        health.lastSuccessAt = now;
+        return;
+    }
+
+    health.consecutiveFailures++;
+    health.lastErrorCode = errorCode;
+    health.lastFailureAt = now;
+
+    bool probeFailed = health.state == ControllerHealth::State::HalfOpen;
+    if (probeFailed || health.consecutiveFailures >= policy.failureThreshold) {
+        health.cooldownMs = probeFailed
+            ? std::min(health.cooldownMs * 2, policy.maxOpenMs)
+            : policy.openMs;
+        if (health.cooldownMs <= 0) health.cooldownMs = policy.openMs;
+        health.state = ControllerHealth::State::Open;
+        health.openUntil = now + health.cooldownMs;
+        WLOG_WARN(L"[HEALTH] [!] Circuit opened for " << widen(ip) << L" after " << health.consecutiveFailures
+                  << L" failure(s), next probe in " << health.cooldownMs / 1000 << L" s");
+    }
+}
+
+ControllerHealth ControllerHealthCache::snapshot(const std::string& ip) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = controllers.find(ip);
+    return it == controllers.end() ? ControllerHealth() : it->second;
+}
+
+bool ControllerHealthCache::showsContent(const std::string& ip, uint64_t contentHash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = controllers.find(ip);
+    return contentHash != 0 && it != controllers.end() && it->second.contentHash == contentHash;
+}
+
+void ControllerHealthCache::recordContent(const std::string& ip, uint64_t contentHash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ControllerHealth& health = controllers[ip];
+    health.contentHash = contentHash;
+    health.contentSentAt = nowUnixMs();
+    dirty = true;
+}
+
+void ControllerHealthCache::load() {
+    if (path.empty()) {
+        return;
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        return; // first run, nothing cached yet
+    }
+
+    try {
+        json data = json::parse(file);
+        for (auto it = data["controllers"].begin(); it != data["controllers"].end(); ++it) {
+            const json& entry = it.value();
+            ControllerHealth health;
+            health.state = parseState(entry.value("state", "closed"));
+            health.consecutiveFailures = entry.value("consecutiveFailures", 0);
+            health.lastErrorCode = entry.value("lastErrorCode", 0);
+            health.openUntil = entry.value("openUntil", int64_t(0));
+            health.cooldownMs = entry.value("cooldownMs", int64_t(0));
+            health.lastSuccessAt = entry.value("lastSuccessAt", int64_t(0));
+            health.lastFailureAt = entry.value("lastFailureAt", int64_t(0));
+            health.ewmaLatencyMs = entry.value("ewmaLatencyMs", 0.0);
+            health.recentOutcomes = entry.value("recentOutcomes", 0u);
+            health.recentCount = entry.value("recentCount", 0u);
+            health.contentHash = std::stoull(entry.value("contentHash", "0"), nullptr, 16);
+            health.contentSentAt = entry.value("contentSentAt", int64_t(0));
+            controllers[it.key()] = health;
+        }
+        WLOG_INFO(L"[HEALTH] [OK] Loaded " << controllers.size() << L" controller(s) from " << widen(path));
+    } catch (std::exception& e) {
+        // A corrupt cache only costs us the history, never a send
+        std::string err = e.what();
+        WLOG_WARN(L"[HEALTH] [!] Ignoring unreadable health cache: " << widen(err));
+        controllers.clear();
+    }
+}
+
+void ControllerHealthCache::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (path.empty() || !dirty) {
+        return;
+    }
+
+    json data = {{"version", 1}, {"controllers", json::object()}};
+    for (const auto& entry : controllers) {
+        const ControllerHealth& health = entry.second;
+        data["controllers"][entry.first] = {
+            {"state", stateName(health.state)},
+            {"consecutiveFailures", health.consecutiveFailures},
+            {"lastErrorCode", health.lastErrorCode},
+            {"openUntil", health.openUntil},
+            {"cooldownMs", health.cooldownMs},
+            {"lastSuccessAt", health.lastSuccessAt},
+            {"lastFailureAt", health.lastFailureAt},
+            {"ewmaLatencyMs", health.ewmaLatencyMs},
+            {"recentOutcomes", health.recentOutcomes},
+            {"recentCount", health.recentCount},
+            {"contentHash", hashToHex(health.contentHash)},
+            {"contentSentAt", health.contentSentAt}
+        };
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file) {
+            WLOG_WARN(L"[HEALTH] [!] Cannot write health cache: " << widen(tempPath));
+            return;
+        }
+        file << data.dump(2);
+    }
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        WLOG_WARN(L"[HEALTH] [!] Cannot replace health cache: " << widen(path));
+        return;
+    }
+    dirty = false;
+}
+
+DisplayResult sendWithHealthCheck(ControllerHealthCache* cache, const std::string& ip, const std::function<DisplayResult()>& send) {
+    if (cache && !cache->allowAttempt(ip)) {
+        ControllerHealth health = cache->snapshot(ip);
+        WLOG_ERROR(L"[HEALTH] [X] Skipping " << widen(ip) << L" - circuit open (last error code: "
+                   << health.lastErrorCode << L")");
+        DisplayResult result;
+        result.displayIpAddress = ip;
+        result.skipped = true;
+        result.errorCode = health.lastErrorCode;
+        result.error = "Controller marked unreachable, skipped until next probe";
+        return result;
+    }
+
+    DisplayResult result = send();
+    // Build failures (no SDK error code) say nothing about the controller
+    if (cache && (result.success || result.errorCode != 0)) {
+        cache->recordOutcome(ip, result.success, result.errorCode, result.durationMs);
+    }
+    return result;
+}
+
+DisplayResult sendIfChanged(ControllerHealthCache* cache, const std::string& ip, uint64_t contentHash, bool force,
+                            const std::function<DisplayResult()>& send) {
+    if (cache && !force && cache->showsContent(ip, contentHash)) {
+        WLOG_INFO(L"[CACHE] [OK] " << widen(ip) << L" already shows this content (" << widen(hashToHex(contentHash))
+                  << L"), not sending");
+        DisplayResult result;
+        result.displayIpAddress = ip;
+        result.success = true;
+        result.unchanged = true;
+        result.contentHash = hashToHex(contentHash);
+        return result;
+    }
+
+    DisplayResult result = sendWithHealthCheck(cache, ip, send);
+    result.contentHash = hashToHex(contentHash);
+    if (cache && result.success && !result.skipped) {
+        cache->recordContent(ip, contentHash);
+    }
+    return result;
+}
+
+TimeSyncResult syncWithHealthCheck(ControllerHealthCache* cache, const TimeSyncConfig& timeSync, const std::function<TimeSyncResult()>& sync) {
+    const std::string& ip = timeSync.timeDisplayIpAddress;
+    if (!cache || !timeSync.adjustTime || ip.empty()) {
+        return sync();
+    }
+
+    if (!cache->allowAttempt(ip)) {
+        WLOG_ERROR(L"[HEALTH] [X] Skipping time sync of " << widen(ip) << L" - circuit open");
+        TimeSyncResult result;
+        result.skipped = true;
+        result.errorCode = cache->snapshot(ip).lastErrorCode;
+        return result;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    TimeSyncResult result = sync();
+    double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    if (result.success || result.errorCode != 0) {
+        cache->recordOutcome(ip, result.success, result.errorCode, latencyMs);
+    }
+    return result;
+}
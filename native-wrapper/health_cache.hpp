@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "send_pipeline.hpp"
+
+// ------------------------------ Circuit breaker tuning ------------------------------ //
+struct HealthPolicy {
+    int failureThreshold = 2;           // consecutive device failures that open the circuit
+    int64_t openMs = 60 * 1000;         // first cool-down before a half-open probe
+    int64_t maxOpenMs = 15 * 60 * 1000; // cool-down doubles after every failed probe, up to this
+    double latencyAlpha = 0.3;          // weight of the newest sample in the latency EWMA
+};
+
+// ------------------------------ What we know about one controller ------------------------------ //
+// closed    - sends go through
+// open      - controller considered dead, sends are skipped until openUntil
+// half-open - cool-down over, exactly one probe send is let through; its outcome closes or re-opens the circuit
+struct ControllerHealth {
+    enum class State { Closed, Open, HalfOpen };
+    State state = State::Closed;
+    int consecutiveFailures = 0;
+    int lastErrorCode = 0;
+    int64_t openUntil = 0;              // unix ms
+    int64_t cooldownMs = 0;
+    int64_t lastSuccessAt = 0;          // unix ms
+    int64_t lastFailureAt = 0;          // unix ms
+    double ewmaLatencyMs = 0.0;
+    uint32_t recentOutcomes = 0;        // bit i = outcome i sends ago (1 = success)
+    uint32_t recentCount = 0;           // valid bits in recentOutcomes, at most 32
+    uint64_t contentHash = 0;           // screen model last sent successfully, 0 = unknown
+    int64_t contentSentAt = 0;          // unix ms
+    bool probeInFlight = false;         // not persisted
+};
+
+// ------------------------------ Per-controller health, keyed by IP, optionally persisted (--health-cache=<file.json>) ------------------------------ //
+// Only device failures (an SDK error code after send / adjust time) count against a controller; screens that
+// could not be built are configuration problems and leave its health alone. Thread-safe.
+// It also remembers which content each sign shows. HDSDK cannot tell us whether a controller rebooted, so any
+// device failure (the usual symptom of a power cut) forgets the content and the next run sends again.
+class ControllerHealthCache {
+public:
+    explicit ControllerHealthCache(const std::string& path = "", HealthPolicy policy = HealthPolicy());
+
+    // ---------- Whether a send to `ip` should be attempted now; claims the half-open probe slot when due ---------- //
+    bool allowAttempt(const std::string& ip);
+
+    // ---------- Records the outcome of an attempted send (latency feeds the EWMA) ---------- //
+    void recordOutcome(const std::string& ip, bool success, int errorCode, double latencyMs);
+
+    ControllerHealth snapshot(const std::string& ip);
+
+    // ---------- Content last delivered to the controller ---------- //
+    bool showsContent(const std::string& ip, uint64_t contentHash);
+    void recordContent(const std::string& ip, uint64_t contentHash);
+
+    // ---------- Writes the cache file (temp file + rename) if anything changed; no-op without a path ---------- //
+    void save();
+
+private:
+    void load();
+
+    std::string path;
+    HealthPolicy policy;
+    std::mutex mutex;
+    std::unordered_map<std::string, ControllerHealth> controllers;
+    bool dirty = false;
+};
+
+// ------------------------------ Runs `send` unless the controller's circuit is open, and records the outcome ------------------------------ //
+// `cache` may be null (health tracking disabled). Skipped sends come back failed with `skipped` set.
+DisplayResult sendWithHealthCheck(ControllerHealthCache* cache, const std::string& ip, const std::function<DisplayResult()>& send);
+// ------------------------------ Like sendWithHealthCheck, but skips controllers that already show `contentHash` ------------------------------ //
+// Unless `force` is set. Unchanged sends come back successful with `unchanged` set; successful sends store the hash.
+DisplayResult sendIfChanged(ControllerHealthCache* cache, const std::string& ip, uint64_t contentHash, bool force,
+                            const std::function<DisplayResult()>& send);
+TimeSyncResult syncWithHealthCheck(ControllerHealthCache* cache, const TimeSyncConfig& timeSync, const std::function<TimeSyncResult()>& sync);
@@ -0,0 +1,94 @@
+#include "log.hpp"
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<int> runtimeLogLevel{ static_cast<int>(LogLevel::Info) };
+
+namespace {
+
+const size_t kFlushThreshold = 64 * 1024;   // wchar_t, flushed early so fleet runs do not hold megabytes
+
+std::mutex logMutex;
+std::wstring logBuffer;
+
+// ---------- Must be called with logMutex held ---------- //
+void writeBuffer() {
+    if (logBuffer.empty()) return;
+    std::wcerr << logBuffer << std::flush;
+    logBuffer.clear();
+}
+
+void appendLine(const std::wstring& line) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    logBuffer += line;
+    logBuffer += L'\n';
+    if (logBuffer.size() >= kFlushThreshold) {
+        writeBuffer();
+    }
+}
+
+// ---------- Per-thread streams; a stack, because a logged expression may itself log ---------- //
+struct LineStreams {
+    std::vector<std::unique_ptr<std::wostringstream>> streams;
+    size_t depth = 0;
+};
+
+LineStreams& lineStreams() {
+    thread_local LineStreams lines;
+    return lines;
+}
+
+} // namespace
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    static const struct { const char* name; LogLevel level; } kLevels[] = {
+        { "off", LogLevel::Off },
+        { "error", LogLevel::Error },
+        { "warn", LogLevel::Warn },
+        { "info", LogLevel::Info },
+        { "debug", LogLevel::Debug },
+    };
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+void setLogLevel(LogLevel level) {
+    runtimeLogLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void flushLog() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    writeBuffer();
+}
+
+LogLine::LogLine() {
+    LineStreams& lines = lineStreams();
+    if (lines.depth == lines.streams.size()) {
+        lines.streams.emplace_back(new std::wostringstream());
+    }
+    out = lines.streams[lines.depth++].get();
+
+    // Start clean: no text and no std::fixed / setprecision left over from the previous line
+    out->str(std::wstring());
+    out->clear();
+    out->flags(std::ios_base::dec | std::ios_base::skipws);
+    out->precision(6);
+    out->width(0);
+    out->fill(L' ');
+}
+
+LogLine::~LogLine() {
+    --lineStreams().depth;
+}
+
+void LogLine::commit() {
+    appendLine(out->str());
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+// ------------------------------ Console log on stderr: level-filtered, buffered, flushed once per command ------------------------------ //
+// Lines are collected in memory and written in one go before a result record goes out (see result_channel.hpp),
+// when the buffer passes 64 KiB and at exit.
+//   --log-level=off|error|warn|info|debug   (default info)
+//   --quiet                                 same as --log-level=off
+// [X] lines are errors, [!] lines warnings, banners and status lines info, per-area / per-text detail debug.
+enum class LogLevel { Off = 0, Error = 1, Warn = 2, Info = 3, Debug = 4 };
+
+// ---------- Compile-time ceiling: statements above it are dropped by the compiler (e.g. -DWRAPPER_LOG_MAX_LEVEL=2) ---------- //
+#ifndef WRAPPER_LOG_MAX_LEVEL
+#define WRAPPER_LOG_MAX_LEVEL 4
+#endif
+
+extern std::atomic<int> runtimeLogLevel;
+
+inline bool logEnabled(LogLevel level) {
+    return static_cast<int>(level) <= WRAPPER_LOG_MAX_LEVEL &&
+           static_cast<int>(level) <= runtimeLogLevel.load(std::memory_order_relaxed);
+}
+
+// ---------- "off" / "error" / "warn" / "info" / "debug"; false leaves `level` untouched ---------- //
+bool parseLogLevel(const std::string& name, LogLevel& level);
+void setLogLevel(LogLevel level);
+
+// ---------- Writes everything buffered so far to the console ---------- //
+void flushLog();
+
+// ------------------------------ One line under construction, formatted into a reused per-thread stream ------------------------------ //
+class LogLine {
+public:
+    LogLine();
+    ~LogLine();
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    std::wostream& stream() { return *out; }
+    void commit();          // appends the line to the buffer
+
+private:
+    std::wostringstream* out;
+};
+
+// ---------- The streamed expression is only evaluated when the level is enabled ---------- //
+#define WLOG_AT(level, expr)                  \
+    do {                                      \
+        if (logEnabled(level)) {              \
+            LogLine logLine_;                 \
+            logLine_.stream() << expr;        \
+            logLine_.commit();                \
+        }                                     \
+    } while (0)
+
+#define WLOG_ERROR(expr) WLOG_AT(LogLevel::Error, expr)
+#define WLOG_WARN(expr) WLOG_AT(LogLevel::Warn, expr)
+#define WLOG_INFO(expr) WLOG_AT(LogLevel::Info, expr)
+#define WLOG_DEBUG(expr) WLOG_AT(LogLevel::Debug, expr)
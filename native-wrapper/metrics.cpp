@@ -0,0 +1,250 @@
+#include "metrics.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <locale>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "log.hpp"
+#include "utf8.hpp"
+
+std::atomic<bool> metricsActive(false);
+
+namespace {
+
+// ---------- Log-linear buckets: exact below 16 us, then 8 sub-buckets per power of two up to 2^36 us (~19 h) ---------- //
+const int kSubBucketBits = 3;
+const int kSubBuckets = 1 << kSubBucketBits;
+const int kExactBuckets = 2 * kSubBuckets;
+const int kMaxMagnitude = 35;
+const int kBucketCount = kExactBuckets + (kMaxMagnitude - kSubBucketBits) * kSubBuckets;
+
+int bucketIndex(uint64_t us) {
+    if (us < static_cast<uint64_t>(kExactBuckets)) return static_cast<int>(us);
+    int magnitude = 63;
+    while (!(us >> magnitude)) --magnitude;
+    if (magnitude > kMaxMagnitude) return kBucketCount - 1;
+    int shift = magnitude - kSubBucketBits;
+    int subBucket = static_cast<int>(us >> shift) - kSubBuckets;
+    return kExactBuckets + (magnitude - kSubBucketBits - 1) * kSubBuckets + subBucket;
+}
+
+// ---------- Largest duration (us) that still falls into `index` ---------- //
+uint64_t bucketUpperBound(int index) {
+    if (index < kExactBuckets) return static_cast<uint64_t>(index);
+    int magnitude = (index - kExactBuckets) / kSubBuckets + kSubBucketBits + 1;
+    int subBucket = (index - kExactBuckets) % kSubBuckets;
+    int shift = magnitude - kSubBucketBits;
+    return (static_cast<uint64_t>(kSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+// ---------- One label set; written by the owning thread only, read by the writer ---------- //
+struct Series {
+    std::string call;
+    std::string displayIpAddress;
+    std::string cardType;
+    int errorCode = 0;
+    std::atomic<uint64_t> sumUs;
+    std::atomic<uint64_t> buckets[kBucketCount];   // the call count is their sum, so a read mid-update stays consistent
+    Series* next = nullptr;
+
+    Series() : sumUs(0) {
+        for (std::atomic<uint64_t>& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+};
+
+// ---------- Single writer, so a relaxed load + store does what a locked fetch_add would ---------- //
+void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// ---------- The series of one thread; new series are published at the head of a list the writer walks ---------- //
+struct Shard {
+    std::atomic<Series*> head;
+    std::unordered_map<std::string, Series*> index;   // owning thread only
+    Shard() : head(nullptr) {}
+};
+
+// ---------- Shards outlive their threads: fan-out threads come and go, their counts must not ---------- //
+// A finished thread hands its shard to the next new one, so a daemon does not grow a shard per command.
+struct Registry {
+    std::mutex mutex;
+    std::vector<Shard*> shards;
+    std::vector<Shard*> freeShards;
+    std::mutex writeMutex;
+    std::string path;
+};
+
+// Never destroyed: the periodic writer may still run while the process tears down
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ShardLease {
+    Shard* shard;
+
+    ShardLease() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (!reg.freeShards.empty()) {
+            shard = reg.freeShards.back();
+            reg.freeShards.pop_back();
+        } else {
+            shard = new Shard();
+            reg.shards.push_back(shard);
+        }
+    }
+
+    ~ShardLease() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.freeShards.push_back(shard);
+    }
+};
+
+Shard& threadShard() {
+    thread_local ShardLease lease;
+    return *lease.shard;
+}
+
+Series& findSeries(Shard& shard, const SdkCall& call, const std::string& displayIpAddress, const std::string& cardType) {
+    std::string key = call.call + '\x1f' + displayIpAddress + '\x1f' + cardType + '\x1f' + std::to_string(call.errorCode);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) return *found->second;
+
+    Series* series = new Series();
+    series->call = call.call;
+    series->displayIpAddress = displayIpAddress;
+    series->cardType = cardType;
+    series->errorCode = call.errorCode;
+    series->next = shard.head.load(std::memory_order_relaxed);
+    shard.head.store(series, std::memory_order_release);
+    shard.index.emplace(key, series);
+    return *series;
+}
+
+// ---------- Sum of every shard's series with the same labels ---------- //
+struct Aggregate {
+    std::string labels;
+    uint64_t count = 0;
+    uint64_t sumUs = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(kBucketCount, 0);
+};
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string renderMetrics() {
+    std::map<std::string, Aggregate> aggregates;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (Shard* shard : reg.shards) {
+            for (Series* series = shard->head.load(std::memory_order_acquire); series; series = series->next) {
+                std::string labels = "call=\"" + escapeLabel(series->call) + "\",display=\"" + escapeLabel(series->displayIpAddress) +
+                                     "\",card_type=\"" + escapeLabel(series->cardType) + "\",error_code=\"" + std::to_string(series->errorCode) + "\"";
+                Aggregate& aggregate = aggregates[labels];
+                aggregate.labels = labels;
+                aggregate.sumUs += series->sumUs.load(std::memory_order_relaxed);
+                for (int b = 0; b < kBucketCount; ++b) {
+                    uint64_t calls = series->buckets[b].load(std::memory_order_relaxed);
+                    aggregate.buckets[b] += calls;
+                    aggregate.count += calls;
+                }
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out.precision(10);
+    out << "# TYPE wrapper_sdk_calls counter\n";
+    out << "# HELP wrapper_sdk_calls HDSDK calls by display, card type and Hd_GetSDKLastError code.\n";
+    for (const auto& entry : aggregates) {
+        out << "wrapper_sdk_calls_total{" << entry.second.labels << "} " << entry.second.count << "\n";
+    }
+
+    // Only buckets where the cumulative count grows are written; +Inf always is
+    out << "# TYPE wrapper_sdk_call_duration_seconds histogram\n";
+    out << "# UNIT wrapper_sdk_call_duration_seconds seconds\n";
+    out << "# HELP wrapper_sdk_call_duration_seconds HDSDK call latency.\n";
+    for (const auto& entry : aggregates) {
+        const Aggregate& aggregate = entry.second;
+        uint64_t cumulative = 0;
+        for (int b = 0; b < kBucketCount; ++b) {
+            if (aggregate.buckets[b] == 0) continue;
+            cumulative += aggregate.buckets[b];
+            out << "wrapper_sdk_call_duration_seconds_bucket{" << aggregate.labels << ",le=\""
+                << static_cast<double>(bucketUpperBound(b)) / 1e6 << "\"} " << cumulative << "\n";
+        }
+        out << "wrapper_sdk_call_duration_seconds_bucket{" << aggregate.labels << ",le=\"+Inf\"} " << aggregate.count << "\n";
+        out << "wrapper_sdk_call_duration_seconds_count{" << aggregate.labels << "} " << aggregate.count << "\n";
+        out << "wrapper_sdk_call_duration_seconds_sum{" << aggregate.labels << "} " << static_cast<double>(aggregate.sumUs) / 1e6 << "\n";
+    }
+    out << "# EOF\n";
+    return out.str();
+}
+
+} // namespace
+
+void enableMetrics(const std::string& path, int intervalSeconds) {
+    registry().path = path;
+    metricsActive.store(true, std::memory_order_relaxed);
+    if (intervalSeconds <= 0) return;
+
+    std::thread([intervalSeconds]() {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(intervalSeconds));
+            writeMetrics();
+        }
+    }).detach();
+}
+
+void writeMetrics() {
+    Registry& reg = registry();
+    if (reg.path.empty()) return;
+    std::string text = renderMetrics();
+
+    std::lock_guard<std::mutex> lock(reg.writeMutex);
+    std::string tempPath = reg.path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out << text;
+        if (!out) {
+            WLOG_WARN(L"[METRICS] [!] Could not write " << widen(tempPath));
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, reg.path, ec);
+    if (ec) {
+        WLOG_WARN(L"[METRICS] [!] Could not replace " << widen(reg.path) << L": " << widen(ec.message()));
+    }
+}
+
+void recordSdkCalls(const std::string& displayIpAddress, const std::string& cardType, const std::vector<SdkCall>& calls) {
+    if (!metricsEnabled() || calls.empty()) return;
+    Shard& shard = threadShard();
+    for (const SdkCall& call : calls) {
+        Series& series = findSeries(shard, call, displayIpAddress, cardType);
+        uint64_t durationUs = call.durationUs > 0 ? static_cast<uint64_t>(call.durationUs) : 0;
+        bump(series.sumUs, durationUs);
+        bump(series.buckets[bucketIndex(durationUs)], 1);
+    }
+}
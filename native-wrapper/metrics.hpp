@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "send_pipeline.hpp"
+
+// ------------------------------ SDK call metrics in OpenMetrics text format (--metrics=<file.prom>) ------------------------------ //
+// Per SDK call, display IP, card type and Hd_GetSDKLastError code:
+//   wrapper_sdk_calls_total                  counter
+//   wrapper_sdk_call_duration_seconds        histogram, log-linear (HDR-style) buckets within 12.5% of the true latency
+// The file is rewritten every --metrics-interval=<seconds> (default 15) and at exit, through a temporary file and a
+// rename, so a node_exporter / windows_exporter textfile collector never reads half a file. Each thread records into
+// its own shard without locks or atomic read-modify-writes; the writer sums the shards.
+
+extern std::atomic<bool> metricsActive;
+
+inline bool metricsEnabled() {
+    return metricsActive.load(std::memory_order_relaxed);
+}
+
+// ---------- Starts recording and the periodic writer ---------- //
+void enableMetrics(const std::string& path, int intervalSeconds);
+
+// ---------- Rewrites the metrics file with everything recorded so far ---------- //
+void writeMetrics();
+
+// ---------- The calls made for one display; the time display has no card type ---------- //
+void recordSdkCalls(const std::string& displayIpAddress, const std::string& cardType, const std::vector<SdkCall>& calls);
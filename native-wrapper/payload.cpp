@@ -0,0 +1,741 @@
+#include "payload.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include "utf8.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+bool isYes(const std::string& value) {
+    return value == "Y" || value == "y";
+}
+
+// ---------- "128x64, 96x64" -> module sizes ---------- //
+std::vector<ModuleSize> parseCellSizes(const std::string& value) {
+    std::vector<ModuleSize> sizes;
+    std::istringstream parts(value);
+    std::string part;
+    while (std::getline(parts, part, ',')) {
+        ModuleSize size;
+        char separator = 0;
+        std::istringstream cell(part);
+        if (!(cell >> size.width >> separator >> size.height) || (separator != 'x' && separator != 'X') ||
+            size.width <= 0 || size.height <= 0) {
+            throw std::runtime_error("Invalid gridCellSizes entry '" + part + "' (expected WIDTHxHEIGHT)");
+        }
+        sizes.push_back(size);
+    }
+    return sizes;
+}
+
+std::string cellSizesString(const std::vector<ModuleSize>& sizes) {
+    std::string value;
+    for (const ModuleSize& size : sizes) {
+        if (!value.empty()) value += ",";
+        value += std::to_string(size.width) + "x" + std::to_string(size.height);
+    }
+    return value;
+}
+
+// ---------- "1,2,0,3" -> fuel item per cell ---------- //
+std::vector<int> parseCellItems(const std::string& value) {
+    std::vector<int> items;
+    std::istringstream parts(value);
+    std::string part;
+    while (std::getline(parts, part, ',')) {
+        try {
+            int item = std::stoi(part);
+            if (item < 0) throw std::out_of_range(part);
+            items.push_back(item);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid gridCellItems entry '" + part + "' (expected a fuel number, 0 = blank)");
+        }
+    }
+    return items;
+}
+
+std::string cellItemsString(const std::vector<int>& items) {
+    std::string value;
+    for (int item : items) {
+        if (!value.empty()) value += ",";
+        value += std::to_string(item);
+    }
+    return value;
+}
+
+json retryPolicyJson(const RetryPolicy& retry) {
+    return {
+        {"retryMaxAttempts", retry.maxAttempts},
+        {"retryBaseDelayMs", retry.baseDelayMs},
+        {"retryMaxDelayMs", retry.maxDelayMs},
+        {"retryDeadlineMs", retry.deadlineMs},
+        {"retryableErrorCodes", retry.retryableCodes},
+        {"configurationErrorCodes", retry.configurationCodes}
+    };
+}
+
+// ------------------------------ Field readers: one JSON scalar -> one typed field ------------------------------ //
+// They throw without a location; PayloadReader prefixes the path of the value being read.
+
+// ---------- One scalar as the SAX parser reports it; strings can be moved out ---------- //
+struct JsonScalar {
+    enum class Type { Null, Boolean, Integer, Float, String };
+    Type type = Type::Null;
+    bool boolean = false;
+    int64_t integer = 0;
+    double number = 0.0;
+    std::string* text = nullptr;            // String: the value, Float: the literal as written
+};
+
+const char* typeName(const JsonScalar& value) {
+    switch (value.type) {
+        case JsonScalar::Type::Null: return "null";
+        case JsonScalar::Type::Boolean: return "a boolean";
+        case JsonScalar::Type::Integer: return "an integer";
+        case JsonScalar::Type::Float: return "a number";
+        case JsonScalar::Type::String: return "a string";
+    }
+    return "a value";
+}
+
+std::runtime_error unexpected(const char* expected, const JsonScalar& value) {
+    return std::runtime_error(std::string("expected ") + expected + ", got " + typeName(value));
+}
+
+int64_t toInt64(const JsonScalar& value) {
+    if (value.type == JsonScalar::Type::Integer) return value.integer;
+    if (value.type == JsonScalar::Type::Float && value.number == static_cast<double>(static_cast<int64_t>(value.number))) {
+        return static_cast<int64_t>(value.number);
+    }
+    throw unexpected("an integer", value);
+}
+
+int toInt(const JsonScalar& value) {
+    int64_t number = toInt64(value);
+    if (number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("integer " + std::to_string(number) + " is out of range");
+    }
+    return static_cast<int>(number);
+}
+
+std::string toString(JsonScalar& value) {
+    if (value.type != JsonScalar::Type::String) throw unexpected("a string", value);
+    return std::move(*value.text);
+}
+
+bool toYes(JsonScalar& value) {
+    return isYes(toString(value));
+}
+
+bool toBool(const JsonScalar& value) {
+    if (value.type != JsonScalar::Type::Boolean) throw unexpected("true or false", value);
+    return value.boolean;
+}
+
+// ---------- Text that goes to the SDK: strict UTF-8, widened here once so the send path never transcodes ---------- //
+std::string toSdkText(JsonScalar& value, std::wstring& wide) {
+    std::string text = toString(value);
+    utf8ToWide(text, wide);
+    return text;
+}
+
+// ---------- A separator is a single character; "" = none ---------- //
+wchar_t toSeparator(JsonScalar& value) {
+    std::wstring separator = utf8ToWide(toString(value));
+    if (separator.size() > 1) {
+        throw std::runtime_error("must be a single character");
+    }
+    return separator.empty() ? 0 : separator[0];
+}
+
+// ---------- "price" is read back as the decimal the operator typed: the parser hands over the literal ---------- //
+int64_t toPriceMills(JsonScalar& value) {
+    switch (value.type) {
+        case JsonScalar::Type::Integer: return parsePriceMills(std::to_string(value.integer));
+        case JsonScalar::Type::Float: return parsePriceMills(*value.text);
+        case JsonScalar::Type::String: return parsePriceMills(*value.text);
+        default: throw unexpected("a number", value);
+    }
+}
+
+// ---------- Display fields, shared by "config" (main display) and the "displays" entries ---------- //
+// The first entries double as bits of DisplayReader::seen, see kSeen* below.
+struct DisplayField {
+    const char* key;
+    void (*read)(DisplayConfig& display, JsonScalar& value);
+};
+
+const DisplayField kDisplayFields[] = {
+    { "displayIpAddress", [](DisplayConfig& d, JsonScalar& v) { d.displayIpAddress = toSdkText(v, d.wideIpAddress); } },
+    { "cardType", [](DisplayConfig& d, JsonScalar& v) { d.cardType = toString(v); } },
+    { "fontName", [](DisplayConfig& d, JsonScalar& v) { d.fontName = toSdkText(v, d.wideFontName); } },
+    { "screenWidth", [](DisplayConfig& d, JsonScalar& v) { d.screenWidth = toInt(v); } },
+    { "screenHeight", [](DisplayConfig& d, JsonScalar& v) { d.screenHeight = toInt(v); } },
+    { "fontHeight", [](DisplayConfig& d, JsonScalar& v) { d.fontHeight = toInt(v); } },
+    { "decimalFontHeight", [](DisplayConfig& d, JsonScalar& v) { d.decimalFontHeight = toInt(v); } },
+    { "autoFitFont", [](DisplayConfig& d, JsonScalar& v) { d.autoFitFont = toYes(v); } },
+    { "rowColumn", [](DisplayConfig& d, JsonScalar& v) { d.rowColumn = toString(v); } },
+    { "doubleSided", [](DisplayConfig& d, JsonScalar& v) { d.doubleSided = toYes(v); } },
+    { "priceDecimals", [](DisplayConfig& d, JsonScalar& v) {
+        d.priceFormat.decimals = toInt(v);
+        if (d.priceFormat.decimals != 2 && d.priceFormat.decimals != 3) {
+            throw std::runtime_error("must be 2 or 3, got " + std::to_string(d.priceFormat.decimals));
+        }
+    } },
+    { "decimalSeparator", [](DisplayConfig& d, JsonScalar& v) {
+        d.priceFormat.decimalSeparator = toSeparator(v);
+        if (d.priceFormat.decimalSeparator == 0) {
+            throw std::runtime_error("cannot be empty");
+        }
+    } },
+    { "groupSeparator", [](DisplayConfig& d, JsonScalar& v) { d.priceFormat.groupSeparator = toSeparator(v); } },
+    { "currencySymbol", [](DisplayConfig& d, JsonScalar& v) {
+        d.priceFormat.currencySymbol = utf8ToWide(toString(v));
+        if (d.priceFormat.currencySymbol.size() > PriceFormat::kMaxCurrencyLength) {
+            throw std::runtime_error("is longer than " + std::to_string(PriceFormat::kMaxCurrencyLength) + " characters");
+        }
+    } },
+    { "currencyBefore", [](DisplayConfig& d, JsonScalar& v) { d.priceFormat.currencyBefore = toYes(v); } },
+    { "gridRows", [](DisplayConfig& d, JsonScalar& v) { d.grid.rows = toInt(v); } },
+    { "gridColumns", [](DisplayConfig& d, JsonScalar& v) { d.grid.columns = toInt(v); } },
+    { "gridCellSizes", [](DisplayConfig& d, JsonScalar& v) { d.grid.cellSizes = parseCellSizes(toString(v)); } },
+    { "gridGapX", [](DisplayConfig& d, JsonScalar& v) { d.grid.gapX = toInt(v); } },
+    { "gridGapY", [](DisplayConfig& d, JsonScalar& v) { d.grid.gapY = toInt(v); } },
+    { "gridCellItems", [](DisplayConfig& d, JsonScalar& v) { d.grid.cellItems = parseCellItems(toString(v)); } },
+    { "gridSecondSide", [](DisplayConfig& d, JsonScalar& v) { d.grid.secondSide = toString(v); } },
+};
+
+const uint32_t kSeenIpAddress = 1u << 0;
+const uint32_t kSeenCardType = 1u << 1;
+const uint32_t kSeenFontName = 1u << 2;
+const uint32_t kSeenScreenWidth = 1u << 3;
+const uint32_t kSeenScreenHeight = 1u << 4;
+const uint32_t kSeenFontHeight = 1u << 5;
+const uint32_t kSeenDecimalFontHeight = 1u << 6;
+
+// ---------- "config" fields that are not about the main display ---------- //
+struct ConfigField {
+    const char* key;
+    void (*read)(Payload& payload, JsonScalar& value);
+};
+
+const ConfigField kConfigFields[] = {
+    { "timeDisplayIpAddress", [](Payload& p, JsonScalar& v) { p.timeSync.timeDisplayIpAddress = toSdkText(v, p.timeSync.wideIpAddress); } },
+    { "adjustTime", [](Payload& p, JsonScalar& v) { p.timeSync.adjustTime = toYes(v); } },
+    { "timeSyncTimeoutMs", [](Payload& p, JsonScalar& v) { p.timeSync.timeoutMs = toInt(v); } },
+    { "maxParallelDisplays", [](Payload& p, JsonScalar& v) { p.maxParallelDisplays = toInt(v); } },
+    { "retryMaxAttempts", [](Payload& p, JsonScalar& v) { p.retry.maxAttempts = toInt(v); } },
+    { "retryBaseDelayMs", [](Payload& p, JsonScalar& v) { p.retry.baseDelayMs = toInt(v); } },
+    { "retryMaxDelayMs", [](Payload& p, JsonScalar& v) { p.retry.maxDelayMs = toInt(v); } },
+    { "retryDeadlineMs", [](Payload& p, JsonScalar& v) { p.retry.deadlineMs = toInt(v); } },
+};
+
+// ------------------------------ SAX handler that fills a PayloadCommand while the text streams by ------------------------------ //
+// Every container opens a frame; unknown keys open Skip frames, so foreign config fields (logo, fuelNames, ...)
+// cost nothing but the scan. Paths for error messages are only built when something is wrong.
+class PayloadReader : public nlohmann::json_sax<json> {
+public:
+    explicit PayloadReader(PayloadCommand& result) : result(result) {
+        frames.reserve(8);
+    }
+
+    bool null() override {
+        JsonScalar value;
+        return scalar(value);
+    }
+
+    bool boolean(bool val) override {
+        JsonScalar value;
+        value.type = JsonScalar::Type::Boolean;
+        value.boolean = val;
+        return scalar(value);
+    }
+
+    bool number_integer(number_integer_t val) override {
+        JsonScalar value;
+        value.type = JsonScalar::Type::Integer;
+        value.integer = val;
+        return scalar(value);
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        if (val > static_cast<number_unsigned_t>(INT64_MAX)) {
+            fail(path(), "integer " + std::to_string(val) + " is out of range");
+        }
+        return number_integer(static_cast<number_integer_t>(val));
+    }
+
+    bool number_float(number_float_t val, const string_t& literal) override {
+        JsonScalar value;
+        value.type = JsonScalar::Type::Float;
+        value.number = val;
+        if (literal.empty()) {
+            // Binary formats have no literal; the shortest round-trip text gives back the typed decimal
+            literalText = json(val).dump();
+        } else {
+            literalText.assign(literal);
+        }
+        value.text = &literalText;
+        return scalar(value);
+    }
+
+    bool string(string_t& val) override {
+        JsonScalar value;
+        value.type = JsonScalar::Type::String;
+        value.text = &val;
+        return scalar(value);
+    }
+
+    bool binary(binary_t&) override {
+        fail(path(), "unexpected binary value");
+        return false;
+    }
+
+    bool key(string_t& val) override {
+        top().key.assign(val);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        return open(false);
+    }
+
+    bool end_object() override {
+        return close();
+    }
+
+    bool start_array(std::size_t) override {
+        return open(true);
+    }
+
+    bool end_array() override {
+        return close();
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        throw PayloadSyntaxError(ex.what());
+    }
+
+    // ---------- After the last token: defaults and required fields of a "send" command ---------- //
+    void finish() {
+        Payload& payload = result.payload;
+        if (payload.maxParallelDisplays < 1) {
+            payload.maxParallelDisplays = 1;
+        }
+        if (result.command != "send") {
+            return;
+        }
+        if (!configRead) {
+            fail("$.config", "missing");
+        }
+        const struct { uint32_t bit; const char* key; } required[] = {
+            { kSeenIpAddress, "displayIpAddress" }, { kSeenCardType, "cardType" }, { kSeenFontName, "fontName" },
+            { kSeenScreenWidth, "screenWidth" }, { kSeenScreenHeight, "screenHeight" },
+        };
+        for (const auto& field : required) {
+            if (!(mainSeen & field.bit)) fail(std::string("$.config.") + field.key, "missing");
+        }
+        // Auto-fit computes the heights itself
+        if (!(mainSeen & kSeenFontHeight) && !payload.displays[0].autoFitFont) {
+            fail("$.config.fontHeight", "missing");
+        }
+    }
+
+private:
+    enum class Section { Root, Config, Displays, Display, FuelItems, FuelItem, Codes, Skip };
+
+    struct Frame {
+        Section section = Section::Skip;
+        bool isArray = false;
+        std::string key;        // last key of an object
+        size_t index = 0;       // current element of an array
+    };
+
+    PayloadCommand& result;
+    std::vector<Frame> frames;      // grows to the deepest nesting seen, key buffers are reused
+    size_t depth = 0;
+    std::string literalText;
+    bool configRead = false;
+    uint32_t mainSeen = 0;
+    uint32_t displaySeen = 0;
+    bool fuelPriceSeen = false;
+    bool fuelMillsSeen = false;
+    std::vector<int>* codes = nullptr;
+
+    // ---------- Displays listed before "config": their own fields, applied on top of the main display once it is read ---------- //
+    struct DeferredField {
+        const DisplayField* field;
+        JsonScalar value;
+        std::string text;       // owned copy of *value.text
+    };
+    struct DeferredDisplay {
+        size_t index = 0;       // in payload.displays
+        uint32_t seen = 0;
+        std::vector<DeferredField> fields;
+    };
+    std::vector<DeferredDisplay> deferredDisplays;
+
+    Frame& top() { return frames[depth - 1]; }
+    const Frame& top() const { return frames[depth - 1]; }
+
+    [[noreturn]] static void fail(const std::string& where, const std::string& message) {
+        throw std::runtime_error(where + ": " + message);
+    }
+
+    // ---------- "$.displays[1].screenWidth": the value being read ---------- //
+    std::string path() const {
+        std::string text = "$";
+        for (size_t level = 0; level < depth; ++level) {
+            const Frame& frame = frames[level];
+            text += frame.isArray ? "[" + std::to_string(frame.index) + "]" : "." + frame.key;
+        }
+        return text;
+    }
+
+    // ---------- The container being closed, without its last key ---------- //
+    std::string containerPath() const {
+        std::string text = path();
+        const Frame& frame = frames[depth - 1];
+        return text.substr(0, text.size() - (frame.isArray ? std::to_string(frame.index).size() + 2 : frame.key.size() + 1));
+    }
+
+    const char* containerName(bool isArray) const {
+        return isArray ? "an array" : "an object";
+    }
+
+    // ---------- Element finished: arrays move on to the next index ---------- //
+    void advance() {
+        if (depth > 0 && top().isArray) {
+            ++top().index;
+        }
+    }
+
+    template <typename Table>
+    static const Table* findField(const Table* begin, const Table* end, const std::string& key, uint32_t& bit) {
+        for (const Table* field = begin; field != end; ++field) {
+            if (key == field->key) {
+                bit = 1u << (field - begin);
+                return field;
+            }
+        }
+        return nullptr;
+    }
+
+    bool readDisplayField(DisplayConfig& display, uint32_t& seen, JsonScalar& value) {
+        uint32_t bit = 0;
+        const DisplayField* field = findField(std::begin(kDisplayFields), std::end(kDisplayFields), top().key, bit);
+        if (!field) return false;
+        if (top().section == Section::Display && !configRead) {
+            // Checked now, so errors carry this path; applied again when the main display is known
+            DeferredField deferred = { field, value, value.text ? *value.text : std::string() };
+            deferredDisplays.back().fields.push_back(std::move(deferred));
+        }
+        field->read(display, value);
+        seen |= bit;
+        return true;
+    }
+
+    // ---------- "config" read: deferred displays become copies of the main display with their own fields on top ---------- //
+    void applyDeferredDisplays() {
+        std::vector<DisplayConfig>& displays = result.payload.displays;
+        for (DeferredDisplay& deferred : deferredDisplays) {
+            DisplayConfig& display = displays[deferred.index];
+            display = displays[0];
+            for (DeferredField& field : deferred.fields) {
+                if (field.value.text) field.value.text = &field.text;
+                field.field->read(display, field.value);
+            }
+            if (!(deferred.seen & kSeenDecimalFontHeight)) display.decimalFontHeight = display.fontHeight;
+        }
+        deferredDisplays.clear();
+    }
+
+    bool scalar(JsonScalar& value) {
+        if (depth == 0) {
+            fail("$", std::string("expected an object, got ") + typeName(value));
+        }
+        Frame& frame = top();
+        try {
+            switch (frame.section) {
+                case Section::Root:
+                    if (frame.key == "command") {
+                        result.command = toString(value);
+                    } else if (frame.key == "format") {
+                        result.format = toString(value);
+                    } else if (frame.key == "force") {
+                        result.payload.force = toBool(value);
+                    } else if (frame.key == "config") {
+                        throw unexpected("an object", value);
+                    } else if (frame.key == "displays" || frame.key == "fuelItems") {
+                        throw unexpected("an array", value);
+                    }
+                    break;
+                case Section::Config: {
+                    uint32_t bit = 0;
+                    if (readDisplayField(result.payload.displays[0], mainSeen, value)) {
+                        break;
+                    }
+                    if (const ConfigField* field = findField(std::begin(kConfigFields), std::end(kConfigFields), frame.key, bit)) {
+                        field->read(result.payload, value);
+                    } else if (frame.key == "retryableErrorCodes" || frame.key == "configurationErrorCodes") {
+                        throw unexpected("an array", value);
+                    }
+                    break;
+                }
+                case Section::Display:
+                    readDisplayField(result.payload.displays.back(), displaySeen, value);
+                    break;
+                case Section::FuelItem: {
+                    FuelItem& item = result.payload.fuelItems.back();
+                    if (frame.key == "name") {
+                        item.name = toString(value);
+                    } else if (frame.key == "priceMills") {
+                        item.priceMills = toInt64(value);
+                        fuelMillsSeen = true;
+                        fuelPriceSeen = true;
+                    } else if (frame.key == "price") {
+                        int64_t mills = toPriceMills(value);
+                        if (!fuelMillsSeen) item.priceMills = mills;     // "priceMills" wins over "price"
+                        fuelPriceSeen = true;
+                    }
+                    break;
+                }
+                case Section::Codes:
+                    codes->push_back(toInt(value));
+                    break;
+                case Section::Displays:
+                case Section::FuelItems:
+                    throw unexpected("an object", value);
+                case Section::Skip:
+                    break;
+            }
+        } catch (const std::runtime_error& e) {
+            fail(path(), e.what());
+        }
+        advance();
+        return true;
+    }
+
+    bool open(bool isArray) {
+        Section section = Section::Skip;
+        if (depth == 0) {
+            if (isArray) fail("$", "expected an object, got an array");
+            section = Section::Root;
+        } else {
+            const Frame& parent = top();
+            const std::string& key = parent.key;
+            switch (parent.section) {
+                case Section::Root:
+                    if (key == "config") {
+                        if (isArray) fail(path(), "expected an object, got an array");
+                        section = Section::Config;
+                        if (result.payload.displays.empty()) result.payload.displays.emplace_back();
+                    } else if (key == "displays" || key == "fuelItems") {
+                        if (!isArray) fail(path(), "expected an array, got an object");
+                        section = key == "displays" ? Section::Displays : Section::FuelItems;
+                    } else if (key == "command" || key == "format" || key == "force") {
+                        fail(path(), std::string("expected a single value, got ") + containerName(isArray));
+                    }
+                    break;
+                case Section::Config:
+                    if (key == "retryableErrorCodes" || key == "configurationErrorCodes") {
+                        if (!isArray) fail(path(), "expected an array, got an object");
+                        section = Section::Codes;
+                        codes = key == "retryableErrorCodes" ? &result.payload.retry.retryableCodes : &result.payload.retry.configurationCodes;
+                        codes->clear();
+                    } else {
+                        uint32_t bit = 0;
+                        if (findField(std::begin(kDisplayFields), std::end(kDisplayFields), key, bit) ||
+                            findField(std::begin(kConfigFields), std::end(kConfigFields), key, bit)) {
+                            fail(path(), std::string("expected a single value, got ") + containerName(isArray));
+                        }
+                    }
+                    break;
+                case Section::Displays:
+                    if (isArray) fail(path(), "expected an object, got an array");
+                    section = Section::Display;
+                    // Extra displays start as copies of the main display and override what they list
+                    if (configRead) {
+                        result.payload.displays.push_back(result.payload.displays[0]);
+                    } else {
+                        if (result.payload.displays.empty()) result.payload.displays.emplace_back();
+                        result.payload.displays.emplace_back();
+                        deferredDisplays.emplace_back();
+                        deferredDisplays.back().index = result.payload.displays.size() - 1;
+                    }
+                    displaySeen = 0;
+                    break;
+                case Section::FuelItems:
+                    if (isArray) fail(path(), "expected an object, got an array");
+                    section = Section::FuelItem;
+                    result.payload.fuelItems.emplace_back();
+                    fuelPriceSeen = false;
+                    fuelMillsSeen = false;
+                    break;
+                case Section::Display:
+                case Section::FuelItem: {
+                    uint32_t bit = 0;
+                    bool known = parent.section == Section::Display
+                        ? findField(std::begin(kDisplayFields), std::end(kDisplayFields), key, bit) != nullptr
+                        : key == "name" || key == "price" || key == "priceMills";
+                    if (known) fail(path(), std::string("expected a single value, got ") + containerName(isArray));
+                    break;
+                }
+                case Section::Codes:
+                    fail(path(), std::string("expected an integer, got ") + containerName(isArray));
+                case Section::Skip:
+                    break;
+            }
+        }
+        if (frames.size() == depth) {
+            frames.emplace_back();
+        }
+        Frame& frame = frames[depth++];
+        frame.section = section;
+        frame.isArray = isArray;
+        frame.key.clear();
+        frame.index = 0;
+        return true;
+    }
+
+    bool close() {
+        switch (top().section) {
+            case Section::Config: {
+                // decimalFontHeight defaults to fontHeight
+                DisplayConfig& main = result.payload.displays[0];
+                if (!(mainSeen & kSeenDecimalFontHeight)) main.decimalFontHeight = main.fontHeight;
+                configRead = true;
+                applyDeferredDisplays();
+                break;
+            }
+            case Section::Display: {
+                DisplayConfig& display = result.payload.displays.back();
+                if (!(displaySeen & kSeenIpAddress)) fail(containerPath() + ".displayIpAddress", "missing");
+                if (!configRead) {
+                    deferredDisplays.back().seen = displaySeen;
+                } else if (!(displaySeen & kSeenDecimalFontHeight)) {
+                    display.decimalFontHeight = display.fontHeight;
+                }
+                break;
+            }
+            case Section::FuelItem:
+                if (!fuelPriceSeen) fail(containerPath() + ".price", "missing");
+                break;
+            default:
+                break;
+        }
+        --depth;
+        advance();
+        return true;
+    }
+};
+
+const uint32_t kMaxFrameBytes = 64u << 20;
+
+} // namespace
+
+const char* payloadFormatName(PayloadFormat format) {
+    return format == PayloadFormat::MessagePack ? "msgpack" : "json";
+}
+
+bool parsePayloadFormat(const std::string& name, PayloadFormat& format) {
+    if (name == "json") {
+        format = PayloadFormat::Json;
+    } else if (name == "msgpack") {
+        format = PayloadFormat::MessagePack;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PayloadFormat sniffPayloadFormat(const std::string& bytes) {
+    size_t first = bytes.find_first_not_of(" \t\r\n");
+    return first == std::string::npos || bytes[first] == '{' ? PayloadFormat::Json : PayloadFormat::MessagePack;
+}
+
+bool readPayloadFrame(std::istream& in, PayloadFormat format, std::string& frame) {
+    if (format == PayloadFormat::Json) {
+        if (!std::getline(in, frame)) return false;
+        if (!frame.empty() && frame.back() == '\r') {
+            frame.pop_back();
+        }
+        return true;
+    }
+
+    unsigned char header[4];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    uint32_t length = static_cast<uint32_t>(header[0]) | static_cast<uint32_t>(header[1]) << 8 |
+                      static_cast<uint32_t>(header[2]) << 16 | static_cast<uint32_t>(header[3]) << 24;
+    if (length > kMaxFrameBytes) {
+        throw std::runtime_error("Frame of " + std::to_string(length) + " bytes exceeds the 64 MiB limit");
+    }
+    frame.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&frame[0], length));
+}
+
+PayloadCommand readPayloadCommand(const std::string& bytes, PayloadFormat format) {
+    PayloadCommand command;
+    PayloadReader reader(command);
+    if (format == PayloadFormat::MessagePack) {
+        json::sax_parse(bytes.begin(), bytes.end(), &reader, json::input_format_t::msgpack);
+    } else {
+        json::sax_parse(bytes, &reader);
+    }
+    reader.finish();
+    return command;
+}
+
+std::string singleDisplayPayloadJson(const DisplayConfig& display, const std::vector<FuelItem>& fuelItems, const RetryPolicy& retry) {
+    json config = {
+        {"displayIpAddress", display.displayIpAddress},
+        {"cardType", display.cardType},
+        {"fontName", display.fontName},
+        {"rowColumn", display.rowColumn},
+        {"doubleSided", display.doubleSided ? "Y" : "N"},
+        {"screenWidth", display.screenWidth},
+        {"screenHeight", display.screenHeight},
+        {"fontHeight", display.fontHeight},
+        {"decimalFontHeight", display.decimalFontHeight},
+        {"adjustTime", "N"},
+        {"autoFitFont", display.autoFitFont ? "Y" : "N"},
+        {"priceDecimals", display.priceFormat.decimals},
+        {"decimalSeparator", wideToUtf8(std::wstring(1, display.priceFormat.decimalSeparator))},
+        {"groupSeparator", display.priceFormat.groupSeparator ? wideToUtf8(std::wstring(1, display.priceFormat.groupSeparator)) : ""},
+        {"currencySymbol", wideToUtf8(display.priceFormat.currencySymbol)},
+        {"currencyBefore", display.priceFormat.currencyBefore ? "Y" : "N"},
+        {"gridRows", display.grid.rows},
+        {"gridColumns", display.grid.columns},
+        {"gridCellSizes", cellSizesString(display.grid.cellSizes)},
+        {"gridGapX", display.grid.gapX},
+        {"gridGapY", display.grid.gapY},
+        {"gridCellItems", cellItemsString(display.grid.cellItems)},
+        {"gridSecondSide", display.grid.secondSide}
+    };
+    config.update(retryPolicyJson(retry));
+
+    json items = json::array();
+    for (const FuelItem& item : fuelItems) {
+        items.push_back({{"name", item.name}, {"priceMills", item.priceMills}});
+    }
+
+    json data = {{"config", config}, {"fuelItems", items}};
+    return data.dump();
+}
+
+std::string timeSyncPayloadJson(const TimeSyncConfig& timeSync, const RetryPolicy& retry) {
+    json config = {
+        {"timeDisplayIpAddress", timeSync.timeDisplayIpAddress},
+        {"adjustTime", timeSync.adjustTime ? "Y" : "N"}
+    };
+    config.update(retryPolicyJson(retry));
+
+    json data = {{"command", "syncTime"}, {"config", config}};
+    return data.dump();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "price_format.hpp"
+#include "retry_policy.hpp"
+
+// ------------------------------ Module (LED cabinet) size in pixels ------------------------------ //
+struct ModuleSize {
+    int width = 0;
+    int height = 0;
+};
+
+// ------------------------------ Cabinet grid of one sign side (Grid* INI keys) ------------------------------ //
+// rows/columns 0 = the classic layout: one row (RowColumn=R) or column (C) of ScreenWidth x ScreenHeight modules.
+struct GridLayout {
+    int rows = 0;
+    int columns = 0;
+    std::vector<ModuleSize> cellSizes;  // row-major per cell ("128x64,96x64,..."), empty = every cell ScreenWidth x ScreenHeight
+    int gapX = 0;                       // pixels between columns / rows (and between the two sides)
+    int gapY = 0;
+    std::vector<int> cellItems;         // row-major fuel item per cell (1-based, 0 = blank module), empty = items in order
+    std::string secondSide;             // double-sided: "R" = side 2 right of side 1, "B" = below, empty = along RowColumn
+};
+
+// ------------------------------ One price sign (controller) and how its screen is laid out ------------------------------ //
+struct DisplayConfig {
+    std::string displayIpAddress;
+    std::string cardType;
+    std::string fontName;
+    std::wstring wideIpAddress;     // displayIpAddress and fontName as the SDK takes them, decoded once with the payload
+    std::wstring wideFontName;
+    std::string rowColumn = "R";
+    bool doubleSided = false;
+    int screenWidth = 0;
+    int screenHeight = 0;
+    int fontHeight = 0;
+    int decimalFontHeight = 0;
+    PriceFormat priceFormat;
+    bool autoFitFont = false;   // pick the largest font heights that fit the module (FontHeight / DecimalFontHeight only set the ratio)
+    GridLayout grid;
+};
+
+// ------------------------------ Clock display that gets its time synchronized ------------------------------ //
+struct TimeSyncConfig {
+    std::string timeDisplayIpAddress;
+    std::wstring wideIpAddress;     // decoded once with the payload
+    bool adjustTime = false;
+    int timeoutMs = 30000;      // how long the result waits for the sync running next to the screen sends
+};
+
+struct FuelItem {
+    std::string name;
+    int64_t priceMills = 0;     // 1.005 -> 1005, see price_format.hpp
+};
+
+// ------------------------------ Everything one command asks for ------------------------------ //
+// "config" describes the main display; every entry of the optional "displays" array is an extra
+// display whose fields override the ones from "config" (IP, geometry, card type, layout, fonts).
+struct Payload {
+    std::vector<DisplayConfig> displays;
+    TimeSyncConfig timeSync;
+    std::vector<FuelItem> fuelItems;
+    int maxParallelDisplays = 4;
+    RetryPolicy retry;
+    bool force = false;         // send even if a sign already shows the same content ("force": true or --force)
+};
+
+// ------------------------------ One command line as sent by the app, a parent wrapper or the daemon client ------------------------------ //
+// "send" (default) needs the main display in "config"; "syncTime" only reads the time sync and retry fields
+// of "config"; "ping" and "shutdown" carry nothing.
+struct PayloadCommand {
+    std::string command = "send";
+    std::string format;         // "setFormat": wire format of the commands that follow
+    Payload payload;
+};
+
+// ------------------------------ Wire format of commands on stdin (--input-format=, daemon "setFormat" command) ------------------------------ //
+// Json         one JSON document per line
+// MessagePack  u32 little-endian byte count + the same schema as a MessagePack map: no line limit, no number
+//              text to format or scan. Prices sent as floats are read back as their shortest round-trip decimal.
+enum class PayloadFormat { Json, MessagePack };
+
+const char* payloadFormatName(PayloadFormat format);                    // "json" / "msgpack"
+bool parsePayloadFormat(const std::string& name, PayloadFormat& format);
+
+// ------------------------------ Recorded command bytes (traces): JSON starts like an object, MessagePack with a map marker ------------------------------ //
+PayloadFormat sniffPayloadFormat(const std::string& bytes);
+
+// ------------------------------ Reads the next command of `format`; false at the end of input ------------------------------ //
+// Throws std::runtime_error on a frame above 64 MiB, after which the stream cannot be resynchronized.
+bool readPayloadFrame(std::istream& in, PayloadFormat format, std::string& frame);
+
+// ------------------------------ Malformed JSON, as opposed to a well-formed payload with a bad field ------------------------------ //
+class PayloadSyntaxError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// ------------------------------ Streams the command straight into the typed structs (SAX, no JSON tree) ------------------------------ //
+// Throws PayloadSyntaxError on malformed JSON / MessagePack and std::runtime_error with the path of the offending value on
+// missing or invalid fields, e.g. "$.displays[1].screenWidth: expected an integer, got a string".
+// Extra displays inherit from "config" in any key order; displays listed first are completed when "config" closes.
+PayloadCommand readPayloadCommand(const std::string& bytes, PayloadFormat format = PayloadFormat::Json);
+
+// ------------------------------ Builds a syncTime command, e.g. for a child process ------------------------------ //
+std::string timeSyncPayloadJson(const TimeSyncConfig& timeSync, const RetryPolicy& retry);
+
+// ------------------------------ Builds a payload for a single display (time sync disabled), e.g. for a child process ------------------------------ //
+std::string singleDisplayPayloadJson(const DisplayConfig& display, const std::vector<FuelItem>& fuelItems, const RetryPolicy& retry);
@@ -0,0 +1,155 @@
+#include "perf_trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "json.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+std::atomic<bool> perfTraceActive(false);
+
+namespace {
+
+const size_t kMaxEvents = 1 << 20;      // a runaway daemon stops recording instead of eating memory
+
+struct SpanEvent {
+    const char* name;
+    const char* category;
+    const char* argName;
+    int64_t argValue;
+    int64_t startNs;
+    int64_t durationNs;
+    int tid;
+};
+
+std::mutex traceMutex;
+std::string tracePath;
+std::string traceProcessName;
+std::vector<SpanEvent> events;
+std::vector<json> childEvents;          // already in trace format, with the child's pid
+size_t droppedEvents = 0;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long processId() {
+#ifdef _WIN32
+    return static_cast<long>(GetCurrentProcessId());
+#else
+    return static_cast<long>(getpid());
+#endif
+}
+
+// ---------- Small stable thread numbers read better in the viewer than OS thread IDs ---------- //
+int threadNumber() {
+    static std::atomic<int> nextThread(1);
+    thread_local int number = nextThread++;
+    return number;
+}
+
+} // namespace
+
+void enablePerfTrace(const std::string& path) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    tracePath = path;
+    traceProcessName = std::filesystem::path(path).stem().string();
+    events.reserve(1024);
+    perfTraceActive.store(true, std::memory_order_relaxed);
+}
+
+void writePerfTrace() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (tracePath.empty()) return;
+
+    long pid = processId();
+    json traceEvents = json::array();
+    traceEvents.push_back({ { "name", "process_name" }, { "ph", "M" }, { "pid", pid }, { "args", { { "name", traceProcessName } } } });
+    for (const SpanEvent& event : events) {
+        json entry = {
+            { "name", event.name },
+            { "cat", event.category },
+            { "ph", "X" },
+            { "ts", event.startNs / 1000.0 },
+            { "dur", event.durationNs / 1000.0 },
+            { "pid", pid },
+            { "tid", event.tid },
+        };
+        if (event.argName) {
+            entry["args"] = { { event.argName, event.argValue } };
+        }
+        traceEvents.push_back(std::move(entry));
+    }
+    for (const json& event : childEvents) {
+        traceEvents.push_back(event);
+    }
+
+    json trace = { { "traceEvents", std::move(traceEvents) }, { "displayTimeUnit", "ms" } };
+    if (droppedEvents > 0) {
+        trace["otherData"] = { { "droppedEvents", droppedEvents } };
+    }
+    std::ofstream out(tracePath, std::ios::binary | std::ios::trunc);
+    out << trace.dump();
+}
+
+std::string childPerfTracePath(const std::string& suffix) {
+    if (!perfTraceEnabled()) return "";
+    std::lock_guard<std::mutex> lock(traceMutex);
+    return tracePath + suffix + ".json";
+}
+
+void mergeChildPerfTrace(const std::string& path) {
+    if (path.empty()) return;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return;
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove(path.c_str());
+
+    json trace = json::parse(contents.str(), nullptr, false);
+    if (trace.is_discarded() || !trace.contains("traceEvents") || !trace["traceEvents"].is_array()) return;
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for (json& event : trace["traceEvents"]) {
+        if (events.size() + childEvents.size() >= kMaxEvents) {
+            ++droppedEvents;
+            continue;
+        }
+        childEvents.push_back(std::move(event));
+    }
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category, const char* argName, int64_t argValue)
+    : name(name), category(category), argName(argName), argValue(argValue) {
+    if (perfTraceEnabled()) {
+        startNs = nowNs();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    end();
+}
+
+void TraceSpan::end() {
+    if (startNs < 0) return;
+    SpanEvent event = { name, category, argName, argValue, startNs, nowNs() - startNs, threadNumber() };
+    startNs = -1;
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (events.size() + childEvents.size() >= kMaxEvents) {
+        ++droppedEvents;
+        return;
+    }
+    events.push_back(event);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// ------------------------------ Phase timing spans in Chrome Trace Event format (--trace=<file.json>) ------------------------------ //
+// Open the file in Perfetto (ui.perfetto.dev) or chrome://tracing. Spans are timed with the monotonic steady_clock,
+// which is system-wide, so the spans of child wrappers (merged in when they exit) line up with the parent's.
+// Without --trace a span costs one relaxed atomic load.
+
+extern std::atomic<bool> perfTraceActive;
+
+inline bool perfTraceEnabled() {
+    return perfTraceActive.load(std::memory_order_relaxed);
+}
+
+// ---------- Starts recording; the viewer labels the process with the file name, so a child reads "trace.json.display0" ---------- //
+void enablePerfTrace(const std::string& path);
+
+// ---------- Rewrites the trace file with every span recorded so far (at exit, and after every daemon command) ---------- //
+void writePerfTrace();
+
+// ---------- Trace file for a child wrapper ("" when tracing is off) and merging it back once the child is done ---------- //
+std::string childPerfTracePath(const std::string& suffix);
+void mergeChildPerfTrace(const std::string& path);
+
+// ------------------------------ One complete event ("ph": "X") from construction to destruction ------------------------------ //
+// `name`, `category` and `argName` must outlive the trace (string literals).
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "wrapper", const char* argName = nullptr, int64_t argValue = 0);
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void end();             // ends the span before the scope does; later calls do nothing
+
+private:
+    const char* name;
+    const char* category;
+    const char* argName;
+    int64_t argValue;
+    int64_t startNs = -1;   // -1 = tracing was off when the span started, or it has ended
+};
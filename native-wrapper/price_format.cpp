@@ -0,0 +1,135 @@
+#include "price_format.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// ---------- Copies the currency symbol (length checked when the format was read) ---------- //
+int appendCurrency(wchar_t* buffer, int length, const PriceFormat& format) {
+    for (wchar_t c : format.currencySymbol) {
+        buffer[length++] = c;
+    }
+    return length;
+}
+
+const int kMaxPriceDigits = 15;     // mills below 10^15 = prices below 10^12
+
+} // namespace
+
+int64_t parsePriceMills(const std::string& text) {
+    auto invalid = [&]() { return std::runtime_error("Invalid price: '" + text + "'"); };
+
+    // ---------- [sign] digits [. digits] [e [sign] digits] ---------- //
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+        negative = text[pos] == '-';
+        ++pos;
+    }
+    std::string digits;
+    int fractionDigits = 0;
+    bool seenPoint = false;
+    bool seenDigit = false;
+    for (; pos < text.size(); ++pos) {
+        char c = text[pos];
+        if (c >= '0' && c <= '9') {
+            seenDigit = true;
+            if (seenPoint) ++fractionDigits;
+            if (!digits.empty() || c != '0') digits.push_back(c);     // leading zeros only move the point
+        } else if (c == '.' && !seenPoint) {
+            seenPoint = true;
+        } else {
+            break;
+        }
+    }
+    if (!seenDigit) throw invalid();
+
+    int exponent = 0;
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+        ++pos;
+        bool negativeExponent = false;
+        if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+            negativeExponent = text[pos] == '-';
+            ++pos;
+        }
+        size_t exponentStart = pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            if (exponent < 10000) exponent = exponent * 10 + (text[pos] - '0');
+            ++pos;
+        }
+        if (pos == exponentStart) throw invalid();
+        if (negativeExponent) exponent = -exponent;
+    }
+    if (pos != text.size()) throw invalid();
+    if (digits.empty()) return 0;
+
+    // ---------- value = digits * 10^shift mills; digits below a mill would be rounded twice on a 2-decimal sign ---------- //
+    int shift = exponent - fractionDigits + 3;
+    if (shift < 0) {
+        size_t cut = std::min(static_cast<size_t>(-shift), digits.size());
+        if (digits.find_first_not_of('0', digits.size() - cut) != std::string::npos) {
+            throw std::runtime_error("Price has more than 3 decimals: '" + text + "'");
+        }
+        digits.resize(digits.size() - cut);
+        shift = 0;
+    }
+    if (static_cast<int>(digits.size()) + shift > kMaxPriceDigits) {
+        throw std::runtime_error("Price out of range: '" + text + "'");
+    }
+
+    int64_t mills = 0;
+    for (char c : digits) mills = mills * 10 + (c - '0');
+    for (int i = 0; i < shift; ++i) mills *= 10;
+    return negative ? -mills : mills;
+}
+
+void formatPrice(int64_t priceMills, const PriceFormat& format, FormattedPrice& out) {
+    int decimals = format.decimals == 3 ? 3 : 2;
+    uint64_t scale = decimals == 3 ? 1000 : 100;
+
+    // ---------- Mills -> minor units of the display, half away from zero ---------- //
+    uint64_t magnitude = priceMills < 0 ? 0 - static_cast<uint64_t>(priceMills) : static_cast<uint64_t>(priceMills);
+    if (decimals == 2) {
+        magnitude = (magnitude + 5) / 10;
+    }
+    bool negative = priceMills < 0 && magnitude > 0;
+    uint64_t whole = magnitude / scale;
+    uint64_t fraction = magnitude % scale;
+
+    // ---------- Integer digits, least significant first ---------- //
+    wchar_t digits[24];
+    int digitCount = 0;
+    do {
+        digits[digitCount++] = static_cast<wchar_t>(L'0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+
+    // ---------- [currency] [-] digits, grouped by three ---------- //
+    int length = 0;
+    if (format.currencyBefore) {
+        length = appendCurrency(out.integerPart, length, format);
+    }
+    if (negative) {
+        out.integerPart[length++] = L'-';
+    }
+    for (int d = digitCount - 1; d >= 0; --d) {
+        out.integerPart[length++] = digits[d];
+        if (format.groupSeparator != 0 && d > 0 && d % 3 == 0) {
+            out.integerPart[length++] = format.groupSeparator;
+        }
+    }
+    out.integerLength = length;
+
+    // ---------- separator + fixed number of digits [currency] ---------- //
+    out.fractionPart[0] = format.decimalSeparator;
+    for (int d = decimals; d >= 1; --d) {
+        out.fractionPart[d] = static_cast<wchar_t>(L'0' + fraction % 10);
+        fraction /= 10;
+    }
+    length = decimals + 1;
+    if (!format.currencyBefore) {
+        length = appendCurrency(out.fractionPart, length, format);
+    }
+    out.fractionLength = length;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// ------------------------------ How prices are written on a sign (Price* / Currency* INI keys) ------------------------------ //
+struct PriceFormat {
+    int decimals = 2;                   // 2, or 3 for prices in tenths of a cent
+    wchar_t decimalSeparator = L'.';    // ',' for most EU / Macedonian sites
+    wchar_t groupSeparator = 0;         // thousands grouping ('.', ' ', U+00A0 ...), 0 = none
+    std::wstring currencySymbol;        // empty = none, at most kMaxCurrencyLength characters
+    bool currencyBefore = false;        // "€1.55" instead of "1.55€"
+
+    static const size_t kMaxCurrencyLength = 8;
+};
+
+// ------------------------------ A formatted price in fixed buffers ------------------------------ //
+// integerPart = [currency] [-] digits with grouping     (drawn at FontHeight)
+// fractionPart = separator + decimals digits [currency] (drawn at DecimalFontHeight)
+struct FormattedPrice {
+    static const int kCapacity = 48;
+    wchar_t integerPart[kCapacity];
+    int integerLength = 0;
+    wchar_t fractionPart[kCapacity];
+    int fractionLength = 0;
+
+    std::wstring integerText() const { return std::wstring(integerPart, integerLength); }
+    std::wstring fractionText() const { return std::wstring(fractionPart, fractionLength); }
+};
+
+// ------------------------------ Prices travel as integer mills (thousandths of the currency unit): 1.005 -> 1005 ------------------------------ //
+// Fine enough for 3-decimal prices, so every configured PriceDecimals is an exact integer division.
+const int64_t kMillsPerUnit = 1000;
+
+// ------------------------------ Decimal text ("1.005", "-2", "1.5e2") -> mills, exact ------------------------------ //
+// Throws std::runtime_error on anything that is not a plain decimal number, on non-zero digits beyond the third
+// decimal (rounding them here and again to 2 decimals would show 1.0045 as 1.01) and on prices above 10^12.
+int64_t parsePriceMills(const std::string& text);
+
+// ------------------------------ Writes `priceMills` rounded to format.decimals with integer arithmetic, no heap allocation ------------------------------ //
+// 2 decimals round half away from zero, so 1.005 shows as 1.01.
+void formatPrice(int64_t priceMills, const PriceFormat& format, FormattedPrice& out);
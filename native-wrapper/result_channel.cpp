@@ -0,0 +1,41 @@
+#include "result_channel.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include "log.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+std::mutex resultMutex;
+
+} // namespace
+
+void initResultChannel() {
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+    _setmode(_fileno(stderr), _O_U16TEXT);
+#endif
+}
+
+void writeResult(const ResultRecord& record) {
+    flushLog();
+    // Names and errors can carry bytes from the payload; never let a bad byte cost the whole result
+    std::string line = record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    line += '\n';
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fflush(stdout);
+}
+
+ResultRecord errorResult(const std::string& error) {
+    ResultRecord record;
+    record["success"] = false;
+    record["error"] = error;
+    return record;
+}
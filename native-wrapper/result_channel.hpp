@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include "json.hpp"
+
+// ------------------------------ Result channel: stdout carries result records only, the human log goes to stderr ------------------------------ //
+// One JSON object per line, UTF-8 on every platform. A client reads exactly one line per command (the daemon's
+// ready line is the first record) and never has to sift result lines out of log text. Keys keep insertion order.
+using ResultRecord = nlohmann::ordered_json;
+
+// ---------- Windows: raw bytes on stdout, UTF-16 console text on stderr ---------- //
+void initResultChannel();
+
+// ---------- Flushes the pending log first, so a command's log always precedes its result ---------- //
+void writeResult(const ResultRecord& record);
+
+// ---------- {"success": false, "error": ...} ---------- //
+ResultRecord errorResult(const std::string& error);
@@ -0,0 +1,79 @@
+#include "retry_policy.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "log.hpp"
+#include "perf_trace.hpp"
+
+const char* errorCategoryName(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::Retryable: return "retryable";
+        case ErrorCategory::Configuration: return "configuration";
+        case ErrorCategory::Fatal:
+        default: return "fatal";
+    }
+}
+
+ErrorCategory RetryPolicy::classify(int errorCode) const {
+    if (std::find(retryableCodes.begin(), retryableCodes.end(), errorCode) != retryableCodes.end()) {
+        return ErrorCategory::Retryable;
+    }
+    if (std::find(configurationCodes.begin(), configurationCodes.end(), errorCode) != configurationCodes.end()) {
+        return ErrorCategory::Configuration;
+    }
+    return ErrorCategory::Fatal;
+}
+
+RetryOutcome runWithRetry(const RetryPolicy& policy, const std::function<int()>& attempt, const std::wstring& tag) {
+    // ---------- Jitter source, one per thread so fan-out workers don't share state ---------- //
+    thread_local std::mt19937 rng(std::random_device{}());
+
+    RetryOutcome outcome;
+    auto callStart = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - callStart).count();
+    };
+
+    int maxAttempts = std::max(1, policy.maxAttempts);
+    for (int attemptNumber = 1; attemptNumber <= maxAttempts; ++attemptNumber) {
+        auto attemptStart = std::chrono::steady_clock::now();
+        int errorCode = attempt();
+        outcome.attemptMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - attemptStart).count());
+
+        if (errorCode == 0) {
+            outcome.success = true;
+            outcome.errorCode = 0;
+            if (attemptNumber > 1) {
+                WLOG_INFO(L"[" << tag << L"] [OK] Succeeded on attempt " << attemptNumber << L"/" << maxAttempts);
+            }
+            return outcome;
+        }
+
+        outcome.errorCode = errorCode;
+        outcome.category = policy.classify(errorCode);
+        if (outcome.category != ErrorCategory::Retryable || attemptNumber == maxAttempts) {
+            break;
+        }
+
+        // ---------- Exponential backoff with jitter, unless the next attempt would blow the deadline ---------- //
+        double delayMs = std::min<double>(policy.maxDelayMs, policy.baseDelayMs * static_cast<double>(1 << std::min(attemptNumber - 1, 20)));
+        delayMs = std::uniform_real_distribution<double>(delayMs * 0.5, delayMs)(rng);
+        double lastAttemptMs = outcome.attemptMs.back();
+        if (elapsedMs() + delayMs + lastAttemptMs > policy.deadlineMs) {
+            outcome.deadlineExceeded = true;
+            WLOG_WARN(L"[" << tag << L"] [!] Not retrying - attempt " << attemptNumber + 1
+                      << L" would exceed the " << policy.deadlineMs << L" ms deadline");
+            break;
+        }
+
+        WLOG_WARN(L"[" << tag << L"] [!] Attempt " << attemptNumber << L"/" << maxAttempts << L" failed (Error code: "
+                  << errorCode << L"), retrying in " << static_cast<int>(delayMs) << L" ms");
+        outcome.backoffMs.push_back(delayMs);
+        TraceSpan backoffSpan("backoff", "wrapper", "attempt", attemptNumber);
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(delayMs));
+    }
+
+    return outcome;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// ------------------------------ How an Hd_GetSDKLastError code is handled ------------------------------ //
+// Retryable      transient device/network trouble (13 = timeout), the call is repeated with backoff
+// Configuration  the request itself is wrong (bad card type, IP, geometry); repeating cannot help
+// Fatal          anything else the SDK reports; not repeated
+enum class ErrorCategory { Retryable, Configuration, Fatal };
+
+const char* errorCategoryName(ErrorCategory category);
+
+// ------------------------------ Retry settings for device calls (Hd_SendScreen, Cmd_AdjustTime) ------------------------------ //
+// Read from the payload config (retryMaxAttempts, retryBaseDelayMs, retryMaxDelayMs, retryDeadlineMs,
+// retryableErrorCodes, configurationErrorCodes). HDSDK does not document its codes, so only the timeout
+// is retryable out of the box and unknown codes are treated as fatal.
+struct RetryPolicy {
+    int maxAttempts = 3;                // including the first attempt
+    int baseDelayMs = 500;              // backoff before attempt n is base * 2^(n-2), jittered to [50%, 100%]
+    int maxDelayMs = 4000;
+    int deadlineMs = 30000;             // per send, attempts + backoff; no new attempt starts that would overrun it
+    std::vector<int> retryableCodes = { 13 };
+    std::vector<int> configurationCodes;
+
+    ErrorCategory classify(int errorCode) const;
+};
+
+// ------------------------------ What happened across all attempts of one device call ------------------------------ //
+struct RetryOutcome {
+    bool success = false;
+    int errorCode = 0;                  // of the last failed attempt
+    ErrorCategory category = ErrorCategory::Fatal;
+    std::vector<double> attemptMs;      // duration of every attempt
+    std::vector<double> backoffMs;      // sleep before attempt 2, 3, ...
+    bool deadlineExceeded = false;
+};
+
+// ------------------------------ Runs `attempt` (0 = success, otherwise the SDK error code) under the policy ------------------------------ //
+// `tag` prefixes the log lines, e.g. L"SEND" or L"TIME".
+RetryOutcome runWithRetry(const RetryPolicy& policy, const std::function<int()>& attempt, const std::wstring& tag);
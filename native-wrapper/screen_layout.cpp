@@ -0,0 +1,81 @@
+#include "screen_layout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+ScreenLayout computeScreenLayout(const DisplayConfig& display, int itemCount) {
+    const GridLayout& grid = display.grid;
+    bool isColumn = display.rowColumn == "C";
+
+    // ---------- Classic layout = a 1 x N (row) or N x 1 (column) grid without gaps ---------- //
+    int rows = grid.rows;
+    int columns = grid.columns;
+    if (rows <= 0 || columns <= 0) {
+        rows = isColumn ? itemCount : 1;
+        columns = isColumn ? 1 : itemCount;
+    }
+    int cellCount = rows * columns;
+
+    if (!grid.cellSizes.empty() && static_cast<int>(grid.cellSizes.size()) != cellCount) {
+        throw std::runtime_error("gridCellSizes has " + std::to_string(grid.cellSizes.size()) + " entries for a " +
+                                 std::to_string(rows) + "x" + std::to_string(columns) + " grid");
+    }
+    if (!grid.cellItems.empty() && static_cast<int>(grid.cellItems.size()) != cellCount) {
+        throw std::runtime_error("gridCellItems has " + std::to_string(grid.cellItems.size()) + " entries for a " +
+                                 std::to_string(rows) + "x" + std::to_string(columns) + " grid");
+    }
+    if (grid.gapX < 0 || grid.gapY < 0) {
+        throw std::runtime_error("Grid gaps cannot be negative");
+    }
+
+    // ---------- Slot sizes: widest module per column, highest per row ---------- //
+    auto cellSize = [&](int cell) {
+        return grid.cellSizes.empty() ? ModuleSize{ display.screenWidth, display.screenHeight } : grid.cellSizes[cell];
+    };
+    std::vector<int> columnX(columns + 1, 0);
+    std::vector<int> rowY(rows + 1, 0);
+    std::vector<int> columnWidth(columns, 0);
+    std::vector<int> rowHeight(rows, 0);
+    for (int cell = 0; cell < cellCount; ++cell) {
+        ModuleSize size = cellSize(cell);
+        columnWidth[cell % columns] = std::max(columnWidth[cell % columns], size.width);
+        rowHeight[cell / columns] = std::max(rowHeight[cell / columns], size.height);
+    }
+    for (int c = 0; c < columns; ++c) columnX[c + 1] = columnX[c] + columnWidth[c] + grid.gapX;
+    for (int r = 0; r < rows; ++r) rowY[r + 1] = rowY[r] + rowHeight[r] + grid.gapY;
+    int sideWidth = columns > 0 ? columnX[columns] - grid.gapX : 0;
+    int sideHeight = rows > 0 ? rowY[rows] - grid.gapY : 0;
+
+    // ---------- Second side next to (R) or below (B) the first one ---------- //
+    int sides = display.doubleSided ? 2 : 1;
+    std::string secondSide = grid.secondSide.empty() ? (isColumn ? "B" : "R") : grid.secondSide;
+    if (secondSide != "R" && secondSide != "B") {
+        throw std::runtime_error("gridSecondSide must be R or B, got: " + secondSide);
+    }
+    bool sideBelow = secondSide == "B";
+
+    ScreenLayout layout;
+    layout.sides = sides;
+    layout.width = sideBelow || sides == 1 ? sideWidth : 2 * sideWidth + grid.gapX;
+    layout.height = !sideBelow || sides == 1 ? sideHeight : 2 * sideHeight + grid.gapY;
+    layout.secondSideX = sides == 2 && !sideBelow ? sideWidth + grid.gapX : 0;
+    layout.secondSideY = sides == 2 && sideBelow ? sideHeight + grid.gapY : 0;
+    layout.cells.reserve(cellCount);
+
+    for (int cell = 0; cell < cellCount; ++cell) {
+        int item = grid.cellItems.empty() ? cell + 1 : grid.cellItems[cell];
+        if (item <= 0 || item > itemCount) {
+            continue;
+        }
+        ModuleSize size = cellSize(cell);
+        LayoutCell layoutCell;
+        layoutCell.x = columnX[cell % columns];
+        layoutCell.y = rowY[cell / columns];
+        layoutCell.width = size.width;
+        layoutCell.height = size.height;
+        layoutCell.itemIndex = item - 1;
+        layout.cells.push_back(layoutCell);
+    }
+    return layout;
+}
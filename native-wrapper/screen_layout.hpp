@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include "payload.hpp"
+
+// ------------------------------ One module (area) of the sign and the fuel item it shows ------------------------------ //
+struct LayoutCell {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int itemIndex = 0;      // index into the fuel items
+};
+
+// ------------------------------ Area rectangles of one side, row-major, and where the second side goes ------------------------------ //
+// A double-sided sign shows the same cells again, translated by (secondSideX, secondSideY).
+struct ScreenLayout {
+    int width = 0;          // whole screen, both sides
+    int height = 0;
+    std::vector<LayoutCell> cells;
+    int sides = 1;
+    int secondSideX = 0;
+    int secondSideY = 0;
+};
+
+// ------------------------------ Resolves the grid (or the classic row / column) of a display in one pass ------------------------------ //
+// Columns are as wide as their widest module and rows as high as their highest one; modules sit at the top-left
+// of their slot. Blank modules (item 0, or an item beyond the fuel list) get no area.
+// Throws std::runtime_error when the grid description does not fit together.
+ScreenLayout computeScreenLayout(const DisplayConfig& display, int itemCount);
@@ -0,0 +1,157 @@
+#include "screen_model.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include "font_metrics.hpp"
+#include "perf_trace.hpp"
+#include "price_format.hpp"
+#include "screen_layout.hpp"
+
+namespace {
+
+const uint64_t kScreenModelVersion = 2;
+
+// ---------- FNV-1a over fixed-width little-endian fields, strings length-prefixed ---------- //
+class Fnv1a {
+public:
+    void add(uint64_t value) {
+        for (int b = 0; b < 8; ++b) {
+            addByte(static_cast<uint8_t>(value >> (8 * b)));
+        }
+    }
+
+    void add(int value) { add(static_cast<uint64_t>(static_cast<int64_t>(value))); }
+
+    void add(const std::wstring& text) {
+        add(static_cast<uint64_t>(text.size()));
+        for (wchar_t c : text) {
+            add(static_cast<uint64_t>(c));
+        }
+    }
+
+    uint64_t value() const { return hash; }
+
+private:
+    void addByte(uint8_t byte) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+};
+
+} // namespace
+
+// ------------------------------ Maps string-based card types to integer codes ------------------------------ //
+int mapCardType(const std::string& typeStr) {
+    if (typeStr == "E63") return 47;
+    if (typeStr == "E62") return 58;
+    return 0;
+}
+
+ScreenModel buildScreenModel(const DisplayConfig& display, const std::vector<FuelItem>& fuelItems) {
+    TraceSpan span("layout");
+    ScreenModel model;
+    model.cardType = mapCardType(display.cardType);
+
+    // ---------- Area rectangles of one side from the grid description, plus where the second side goes ---------- //
+    ScreenLayout layout = computeScreenLayout(display, static_cast<int>(fuelItems.size()));
+    model.width = layout.width;
+    model.height = layout.height;
+
+    // ---------- Every price formatted once, whatever number of modules and sides show it ---------- //
+    std::vector<PriceText> prices(fuelItems.size());
+    FormattedPrice formatted;
+    for (size_t i = 0; i < fuelItems.size(); ++i) {
+        formatPrice(fuelItems[i].priceMills, display.priceFormat, formatted);
+        prices[i].integerPart = formatted.integerText();
+        prices[i].decimalPart = formatted.fractionText();
+    }
+
+    // ---------- Auto-fit: largest heights at which every price fits the smallest module ---------- //
+    int fontHeight = display.fontHeight;
+    int decimalFontHeight = display.decimalFontHeight;
+    if (display.autoFitFont && !layout.cells.empty()) {
+        int moduleWidth = layout.cells[0].width;
+        int moduleHeight = layout.cells[0].height;
+        for (const LayoutCell& cell : layout.cells) {
+            moduleWidth = std::min(moduleWidth, cell.width);
+            moduleHeight = std::min(moduleHeight, cell.height);
+        }
+        // FontHeight / DecimalFontHeight keep their proportion; half height when they are not set
+        double decimalRatio = display.fontHeight > 0 && display.decimalFontHeight > 0
+            ? static_cast<double>(display.decimalFontHeight) / display.fontHeight
+            : 0.5;
+        model.fontFit = fitFontHeights(prices, display.fontName, moduleWidth, moduleHeight, decimalRatio);
+        fontHeight = model.fontFit.fontHeight;
+        decimalFontHeight = model.fontFit.decimalFontHeight;
+    }
+
+    // ---------- Integer part widths (= decimal x), measured once per fuel item ---------- //
+    std::vector<int> integerWidths(prices.size(), -1);
+
+    // ---------- Side 1: one area per module, showing the price of its fuel item ---------- //
+    model.fontName = display.wideFontName;
+    model.areas.reserve(layout.cells.size() * layout.sides);
+    for (const LayoutCell& cell : layout.cells) {
+        const PriceText& price = prices[cell.itemIndex];
+        int& integerWidth = integerWidths[cell.itemIndex];
+        if (integerWidth < 0) {
+            // Decimals start where the rendered integer part ends
+            integerWidth = measureTextWidth(price.integerPart, display.fontName, fontHeight);
+        }
+
+        ScreenArea area;
+        area.x = cell.x;
+        area.y = cell.y;
+        area.width = cell.width;
+        area.height = cell.height;
+        area.texts.push_back({ price.integerPart, 0, fontHeight });
+        area.texts.push_back({ price.decimalPart, integerWidth, decimalFontHeight });
+        model.areas.push_back(std::move(area));
+    }
+
+    // ---------- Side 2 shows the same content: a translated copy of side 1 ---------- //
+    if (layout.sides == 2) {
+        size_t sideAreas = model.areas.size();
+        for (size_t a = 0; a < sideAreas; ++a) {
+            ScreenArea area = model.areas[a];
+            area.x += layout.secondSideX;
+            area.y += layout.secondSideY;
+            model.areas.push_back(std::move(area));
+        }
+    }
+
+    return model;
+}
+
+uint64_t screenModelHash(const ScreenModel& model) {
+    Fnv1a hash;
+    hash.add(kScreenModelVersion);
+    hash.add(model.width);
+    hash.add(model.height);
+    hash.add(model.cardType);
+    hash.add(static_cast<uint64_t>(model.areas.size()));
+    for (const ScreenArea& area : model.areas) {
+        hash.add(area.x);
+        hash.add(area.y);
+        hash.add(area.width);
+        hash.add(area.height);
+        hash.add(static_cast<uint64_t>(area.texts.size()));
+        for (const ScreenText& text : area.texts) {
+            hash.add(text.text);
+            hash.add(text.x);
+            hash.add(model.fontName);   // per text, as when each text carried its font
+            hash.add(text.fontHeight);
+        }
+    }
+    return hash.value();
+}
+
+std::string hashToHex(uint64_t hash) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
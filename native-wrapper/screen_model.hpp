@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "font_fit.hpp"
+#include "payload.hpp"
+
+// ------------------------------ Everything that ends up on a sign, computed before any SDK call ------------------------------ //
+// One program with one area per module of the sign (see screen_layout.hpp), each holding the integer and decimal
+// part of its fuel item's price.
+struct ScreenText {
+    std::wstring text;
+    int x = 0;
+    int fontHeight = 0;
+};
+
+struct ScreenArea {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<ScreenText> texts;
+};
+
+struct ScreenModel {
+    int width = 0;
+    int height = 0;
+    int cardType = 0;
+    std::wstring fontName;      // every text of a sign is in the display's font
+    std::vector<ScreenArea> areas;
+    FontFit fontFit;            // heights picked by AutoFitFont=Y (already applied to the texts, not hashed separately)
+};
+
+// ------------------------------ Maps string-based card types to integer codes ------------------------------ //
+int mapCardType(const std::string& typeStr);
+
+// ------------------------------ Lays out the price screen of one display (no SDK calls, no logging), throws on a bad grid ------------------------------ //
+ScreenModel buildScreenModel(const DisplayConfig& display, const std::vector<FuelItem>& fuelItems);
+
+// ------------------------------ Canonical 64-bit FNV-1a hash of the model; equal hashes = identical sign content ------------------------------ //
+// Covers geometry, card type and every area and text item. Bump kScreenModelVersion in screen_model.cpp when the
+// backend starts sending something the model doesn't describe (effects, colors), so old hashes stop matching.
+uint64_t screenModelHash(const ScreenModel& model);
+
+// ------------------------------ 16 lowercase hex digits, for logs and the JSON result ------------------------------ //
+std::string hashToHex(uint64_t hash);
@@ -0,0 +1,360 @@
+#include "send_pipeline.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include "flight_recorder.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
+#include "perf_trace.hpp"
+
+namespace {
+
+// ---------- Times one SDK call and appends it to `calls`; `returnsId` = the -1-on-failure convention ---------- //
+template <typename Call>
+int timedSdkCall(std::vector<SdkCall>& calls, const char* name, int area, bool returnsId, Call&& call) {
+    TraceSpan span(name, "sdk", area >= 0 ? "area" : nullptr, area);
+    auto startTime = std::chrono::steady_clock::now();
+    int value = call();
+    SdkCall record;
+    record.call = name;
+    record.area = area;
+    record.success = returnsId ? value != -1 : value == 0;
+    record.durationUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+    calls.push_back(record);
+    return value;
+}
+
+// ---------- Hands the calls made for one display to the metrics on every way out, exceptions included ---------- //
+struct SdkCallMetrics {
+    std::string displayIpAddress;
+    std::string cardType;
+    const std::vector<SdkCall>& calls;
+    ~SdkCallMetrics() { recordSdkCalls(displayIpAddress, cardType, calls); }
+};
+
+} // namespace
+
+// ------------------------------ Builds the price screen for one display and sends it ------------------------------ //
+DisplayResult sendToDisplay(IDisplayBackend& sdk, const DisplayConfig& display, const ScreenModel& model,
+                            const RetryPolicy& retry) {
+    TraceSpan span("sendToDisplay");
+    auto startTime = std::chrono::steady_clock::now();
+    DisplayResult result;
+    result.displayIpAddress = display.displayIpAddress;
+    result.contentHash = hashToHex(screenModelHash(model));
+    SdkCallMetrics metrics = { display.displayIpAddress, display.cardType, result.sdkCalls };
+    recordFlightEvent(FlightEventKind::Phase, "sendToDisplay", (display.displayIpAddress + " " + result.contentHash).c_str(),
+                      static_cast<int32_t>(model.areas.size()), -1, { model.width, model.height, model.cardType });
+
+    // ---------- Layout comes precomputed in the screen model ---------- //
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                      LAYOUT CALCULATION                            ");
+    WLOG_INFO(L"====================================================================");
+    
+    WLOG_INFO(L"[LAYOUT] Base module: " << display.screenWidth << L"x" << display.screenHeight << L" pixels");
+    WLOG_INFO(L"[LAYOUT] Number of areas: " << model.areas.size());
+    if (display.grid.rows > 0 && display.grid.columns > 0) {
+        WLOG_INFO(L"[LAYOUT] Grid: " << display.grid.rows << L"x" << display.grid.columns << L" modules (gap "
+                  << display.grid.gapX << L"x" << display.grid.gapY << L")" << (display.doubleSided ? L", double-sided" : L""));
+    } else {
+        WLOG_INFO(L"[LAYOUT] Orientation: " << (display.rowColumn == "C" ? L"Column (vertical)" : L"Row (horizontal)")
+                  << (display.doubleSided ? L", double-sided" : L""));
+    }
+    if (model.fontFit.applied) {
+        WLOG_INFO(L"[LAYOUT] " << (model.fontFit.fits ? L"[OK]" : L"[!]") << L" Auto-fit font: " << model.fontFit.fontHeight
+                  << L" / decimals " << model.fontFit.decimalFontHeight << L" (" << model.fontFit.steps << L" steps, "
+                  << model.fontFit.durationUs << L" us)" << (model.fontFit.fits ? L"" : L", prices do not fit even at height 1"));
+    }
+    WLOG_INFO(L"[LAYOUT] [OK] Total screen size: " << model.width << L"x" << model.height << L" pixels");
+
+    // ---------- Create the screen in memory using DLL ---------- //
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                      SCREEN CREATION                               ");
+    WLOG_INFO(L"====================================================================");
+    
+    WLOG_INFO(L"[SCREEN] Creating screen buffer: " << model.width << L"x" << model.height << L" pixels");
+    result.sdkCalls.reserve(3 + model.areas.size() * 3);
+    if (timedSdkCall(result.sdkCalls, "Hd_CreateScreen", -1, false, [&]() {
+            return sdk.createScreen(model.width, model.height, model.cardType);
+        }) != 0) {
+        int errorCode = sdk.lastError();
+        result.sdkCalls.back().errorCode = errorCode;
+        throw std::runtime_error("Hd_CreateScreen failed with code: " + std::to_string(errorCode));
+    }
+    WLOG_INFO(L"[SCREEN] [OK] Screen buffer created successfully");
+
+    // ---------- Add a program to the screen ---------- //
+    WLOG_INFO(L"[SCREEN] Creating program container...");
+    int nProgramID = timedSdkCall(result.sdkCalls, "Hd_AddProgram", -1, true, [&]() { return sdk.addProgram(); });
+    if (nProgramID == -1) {
+        int errorCode = sdk.lastError();
+        result.sdkCalls.back().errorCode = errorCode;
+        throw std::runtime_error("Hd_AddProgram failed with code: " + std::to_string(errorCode));
+    }
+    WLOG_INFO(L"[SCREEN] [OK] Program created (ID: " << nProgramID << L")");
+
+    // ---------- Add every area of the model with its text items ---------- //
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                   ADDING CONTENT TO SCREEN                         ");
+    WLOG_INFO(L"====================================================================");
+    
+    result.areas.reserve(model.areas.size());
+    TraceSpan contentSpan("addContent", "wrapper", "areas", static_cast<int64_t>(model.areas.size()));
+    for (size_t index = 0; index < model.areas.size(); ++index) {
+        const ScreenArea& area = model.areas[index];
+        int areaIndex = static_cast<int>(index);
+        WLOG_DEBUG(L"\n[AREA " << index << L"] Creating area at position (X=" << area.x << L", Y=" << area.y << L")");
+        recordFlightEvent(FlightEventKind::Phase, "area", "", static_cast<int32_t>(area.texts.size()), areaIndex,
+                          { area.x, area.y, area.width, area.height });
+
+        // ---------- Add area to the screen ---------- //
+        int nAreaID = timedSdkCall(result.sdkCalls, "Hd_AddArea", areaIndex, true, [&]() {
+            return sdk.addArea(nProgramID, area.x, area.y, area.width, area.height);
+        });
+        if (nAreaID == -1) {
+            int errorCode = sdk.lastError();
+            result.sdkCalls.back().errorCode = errorCode;
+            throw std::runtime_error("Hd_AddArea for item " + std::to_string(index) +
+                                     " failed with code: " + std::to_string(errorCode));
+        }
+        WLOG_DEBUG(L"[AREA " << index << L"] [OK] Hd_AddArea SUCCESS (Area ID: " << nAreaID << L")");
+        AreaResult areaResult;
+        areaResult.areaId = nAreaID;
+        areaResult.x = area.x;
+        areaResult.y = area.y;
+        areaResult.width = area.width;
+        areaResult.height = area.height;
+
+        // ---------- Add text items (integer part, then the smaller decimal part) ---------- //
+        for (const ScreenText& text : area.texts) {
+            WLOG_DEBUG(L"[AREA " << index << L"] Adding text '" << text.text << L"' (font size: " << text.fontHeight
+                       << L", position: X=" << text.x << L")");
+
+            int nItemID = timedSdkCall(result.sdkCalls, "Hd_AddSimpleTextAreaItem", areaIndex, true, [&]() {
+                return sdk.addText(nAreaID, text.text, text.x, model.fontName, text.fontHeight);
+            });
+            if (nItemID == -1) {
+                int errorCode = sdk.lastError();
+                result.sdkCalls.back().errorCode = errorCode;
+                throw std::runtime_error("Hd_AddSimpleTextAreaItem for item " + std::to_string(index) +
+                                         " failed with code: " + std::to_string(errorCode));
+            }
+            WLOG_DEBUG(L"[AREA " << index << L"] [OK] Text SUCCESS (Item ID: " << nItemID << L")");
+            areaResult.itemIds.push_back(nItemID);
+        }
+        result.areas.push_back(std::move(areaResult));
+    }
+    contentSpan.end();
+
+    // ------------------------------ Send final screen data to the LED display device ------------------------------ //
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                    SENDING TO DISPLAY                              ");
+    WLOG_INFO(L"====================================================================");
+    
+    WLOG_INFO(L"[SEND] Target display: " << display.wideIpAddress);
+    WLOG_INFO(L"[SEND] Transmitting screen data...");
+    TraceSpan sendSpan("sendScreen");
+    RetryOutcome sendOutcome = runWithRetry(retry, [&]() {
+        if (timedSdkCall(result.sdkCalls, "Hd_SendScreen", -1, false, [&]() { return sdk.sendScreen(display.wideIpAddress); }) == 0) {
+            return 0;
+        }
+        int errorCode = sdk.lastError();
+        result.sdkCalls.back().errorCode = errorCode;
+        return errorCode;
+    }, L"SEND");
+    sendSpan.end();
+    result.attempts = static_cast<int>(sendOutcome.attemptMs.size());
+    result.attemptMs = sendOutcome.attemptMs;
+
+    if (!sendOutcome.success) {
+        // If sending fails, log error code and possible hint but continue execution
+        int errorCode = sendOutcome.errorCode;
+        WLOG_ERROR(L"[SEND] [X] FAILED (Error code: " << errorCode << L", " << errorCategoryName(sendOutcome.category)
+                   << L", " << result.attempts << L" attempt(s))");
+        if (errorCode == 13) {
+            WLOG_WARN(L"[SEND] [!] HINT: Timeout error - check device power, network, IP address, firewall");
+        }
+        result.success = false;
+        result.errorCode = errorCode;
+        result.errorCategory = errorCategoryName(sendOutcome.category);
+    } else {
+        WLOG_INFO(L"[SEND] [OK] SUCCESS - Screen data transmitted to display");
+        result.success = true;
+    }
+
+    result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+// ------------------------------ Synchronizes the time display with the system clock ------------------------------ //
+TimeSyncResult syncTime(IDisplayBackend& sdk, const TimeSyncConfig& timeSync, const RetryPolicy& retry) {
+    // ------------------------------ Adjust time on time display if requested ------------------------------ //
+    TraceSpan span("syncTime");
+    TimeSyncResult result;
+    SdkCallMetrics metrics = { timeSync.timeDisplayIpAddress, "", result.sdkCalls };
+    recordFlightEvent(FlightEventKind::Phase, "syncTime", timeSync.timeDisplayIpAddress.c_str());
+    if (timeSync.adjustTime) {
+        WLOG_INFO(L"\n====================================================================");
+        WLOG_INFO(L"                    TIME SYNCHRONIZATION                            ");
+        WLOG_INFO(L"====================================================================");
+        
+        if (!sdk.supportsAdjustTime()) {
+            WLOG_ERROR(L"[TIME] [X] SKIPPED - Function not available in DLL");
+        } else if (timeSync.timeDisplayIpAddress.empty()) {
+            WLOG_ERROR(L"[TIME] [X] SKIPPED - No time display IP configured");
+        } else {
+            WLOG_INFO(L"[TIME] Target display: " << timeSync.wideIpAddress);
+            WLOG_INFO(L"[TIME] Synchronizing with system time...");
+            
+            RetryOutcome adjustOutcome = runWithRetry(retry, [&]() {
+                if (timedSdkCall(result.sdkCalls, "Cmd_AdjustTime", -1, false, [&]() { return sdk.adjustTime(timeSync.wideIpAddress); }) == 0) {
+                    return 0;
+                }
+                int errorCode = sdk.lastError();
+                result.sdkCalls.back().errorCode = errorCode;
+                return errorCode;
+            }, L"TIME");
+            result.attempts = static_cast<int>(adjustOutcome.attemptMs.size());
+
+            if (!adjustOutcome.success) {
+                // If time adjustment fails, log error but don't throw (non-critical)
+                int errorCode = adjustOutcome.errorCode;
+                WLOG_ERROR(L"[TIME] [X] FAILED (Error code: " << errorCode << L", " << result.attempts << L" attempt(s))");
+                if (errorCode == 13) {
+                    WLOG_WARN(L"[TIME] [!] HINT: Timeout - check power, network, IP address");
+                }
+                result.success = false;
+                result.errorCode = errorCode;
+            } else {
+                WLOG_INFO(L"[TIME] [OK] SUCCESS - Time display synchronized");
+                result.success = true;
+            }
+        }
+    } else {
+        result.success = true; // Not requested, so count as "success"
+    }
+
+    return result;
+}
+
+namespace {
+
+ResultRecord sdkCallsJson(const std::vector<SdkCall>& calls) {
+    ResultRecord array = ResultRecord::array();
+    for (const SdkCall& call : calls) {
+        ResultRecord entry;
+        entry["call"] = call.call;
+        if (call.area >= 0) entry["area"] = call.area;
+        entry["success"] = call.success;
+        if (call.errorCode != 0) entry["errorCode"] = call.errorCode;
+        entry["durationUs"] = call.durationUs;
+        array.push_back(std::move(entry));
+    }
+    return array;
+}
+
+ResultRecord areasJson(const std::vector<AreaResult>& areas) {
+    ResultRecord array = ResultRecord::array();
+    for (const AreaResult& area : areas) {
+        ResultRecord entry;
+        entry["areaId"] = area.areaId;
+        entry["x"] = area.x;
+        entry["y"] = area.y;
+        entry["width"] = area.width;
+        entry["height"] = area.height;
+        entry["itemIds"] = area.itemIds;
+        array.push_back(std::move(entry));
+    }
+    return array;
+}
+
+} // namespace
+
+// ------------------------------ Per-display results as a JSON array ------------------------------ //
+ResultRecord displaysJson(const std::vector<DisplayResult>& results) {
+    ResultRecord array = ResultRecord::array();
+    for (const DisplayResult& result : results) {
+        ResultRecord entry;
+        entry["displayIpAddress"] = result.displayIpAddress;
+        entry["success"] = result.success;
+        entry["errorCode"] = result.errorCode;
+        entry["durationMs"] = result.durationMs;
+        entry["attempts"] = result.attempts;
+        if (result.attempts > 1) {
+            entry["attemptMs"] = result.attemptMs;
+        }
+        if (!result.errorCategory.empty()) {
+            entry["errorCategory"] = result.errorCategory;
+        }
+        if (!result.contentHash.empty()) {
+            entry["contentHash"] = result.contentHash;
+        }
+        if (result.unchanged) {
+            entry["unchanged"] = true;
+        }
+        if (result.fontFit.applied) {
+            entry["autoFit"] = {
+                { "fontHeight", result.fontFit.fontHeight },
+                { "decimalFontHeight", result.fontFit.decimalFontHeight },
+                { "fits", result.fontFit.fits },
+                { "steps", result.fontFit.steps },
+                { "durationUs", result.fontFit.durationUs },
+            };
+        }
+        if (result.skipped) {
+            entry["skipped"] = true;
+        }
+        if (!result.error.empty()) {
+            entry["error"] = result.error;
+        }
+        if (!result.areas.empty()) {
+            entry["areas"] = areasJson(result.areas);
+        }
+        if (!result.sdkCalls.empty()) {
+            entry["sdkCalls"] = sdkCallsJson(result.sdkCalls);
+        }
+        array.push_back(std::move(entry));
+    }
+    return array;
+}
+
+ResultRecord timeSyncJson(const TimeSyncResult& result) {
+    ResultRecord record;
+    record["success"] = result.success;
+    record["errorCode"] = result.errorCode;
+    record["attempts"] = result.attempts;
+    if (result.skipped) {
+        record["skipped"] = true;
+    }
+    if (!result.sdkCalls.empty()) {
+        record["sdkCalls"] = sdkCallsJson(result.sdkCalls);
+    }
+    return record;
+}
+
+void readAreas(const nlohmann::json& areas, std::vector<AreaResult>& out) {
+    if (!areas.is_array()) return;
+    for (const nlohmann::json& entry : areas) {
+        AreaResult area;
+        area.areaId = entry.value("areaId", -1);
+        area.x = entry.value("x", 0);
+        area.y = entry.value("y", 0);
+        area.width = entry.value("width", 0);
+        area.height = entry.value("height", 0);
+        area.itemIds = entry.value("itemIds", std::vector<int>());
+        out.push_back(std::move(area));
+    }
+}
+
+void readSdkCalls(const nlohmann::json& calls, std::vector<SdkCall>& out) {
+    if (!calls.is_array()) return;
+    for (const nlohmann::json& entry : calls) {
+        SdkCall call;
+        call.call = entry.value("call", "");
+        call.area = entry.value("area", -1);
+        call.success = entry.value("success", false);
+        call.errorCode = entry.value("errorCode", 0);
+        call.durationUs = entry.value("durationUs", static_cast<int64_t>(0));
+        out.push_back(std::move(call));
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "display_backend.hpp"
+#include "payload.hpp"
+#include "result_channel.hpp"
+#include "screen_model.hpp"
+
+// ------------------------------ One SDK call of a send, in call order ------------------------------ //
+struct SdkCall {
+    std::string call;           // "Hd_CreateScreen", "Hd_AddArea", "Hd_SendScreen", "Cmd_AdjustTime", ...
+    int area = -1;              // area index for Hd_AddArea / Hd_AddSimpleTextAreaItem
+    bool success = false;
+    int errorCode = 0;          // Hd_GetSDKLastError after a failed call
+    int64_t durationUs = 0;
+};
+
+// ------------------------------ One area as created on the controller ------------------------------ //
+struct AreaResult {
+    int areaId = -1;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<int> itemIds;   // Hd_AddSimpleTextAreaItem IDs, integer part then decimals
+};
+
+// ------------------------------ Outcome of one display's screen build + send ------------------------------ //
+struct DisplayResult {
+    std::string displayIpAddress;
+    bool success = false;
+    int errorCode = 0;          // Hd_GetSDKLastError after a failed send
+    std::string error;          // set when the screen could not be built at all
+    double durationMs = 0.0;
+    bool skipped = false;       // not attempted, the controller's circuit is open
+    int attempts = 0;           // Hd_SendScreen calls, including retries
+    std::vector<double> attemptMs;
+    std::string errorCategory;  // "retryable" / "configuration" / "fatal" after a failed send
+    std::string contentHash;    // hash of the screen model that was (or already is) on the sign
+    bool unchanged = false;     // not sent, the sign already shows this content
+    FontFit fontFit;            // heights chosen by auto-fit, reported when applied
+    std::vector<AreaResult> areas;
+    std::vector<SdkCall> sdkCalls;
+};
+
+// ------------------------------ Outcome of the time display synchronization ------------------------------ //
+struct TimeSyncResult {
+    bool success = false;
+    int errorCode = 0;
+    bool skipped = false;
+    int attempts = 0;           // Cmd_AdjustTime calls, including retries
+    std::vector<SdkCall> sdkCalls;
+};
+
+// ------------------------------ Creates, fills and sends the screen of one display from its model ------------------------------ //
+// Throws std::runtime_error if any build step (Hd_CreateScreen, Hd_AddProgram, Hd_AddArea, Hd_AddSimpleTextAreaItem)
+// fails; Hd_SendScreen is retried per `retry` and a final failure is reported in the result instead.
+DisplayResult sendToDisplay(IDisplayBackend& sdk, const DisplayConfig& display, const ScreenModel& model,
+                            const RetryPolicy& retry = RetryPolicy());
+
+// ------------------------------ Runs Cmd_AdjustTime against the time display if requested, retried per `retry` ------------------------------ //
+TimeSyncResult syncTime(IDisplayBackend& sdk, const TimeSyncConfig& timeSync, const RetryPolicy& retry = RetryPolicy());
+
+// ------------------------------ Result record parts: "displays" array and "timeSync" object ------------------------------ //
+ResultRecord displaysJson(const std::vector<DisplayResult>& results);
+ResultRecord timeSyncJson(const TimeSyncResult& result);
+
+// ------------------------------ Reads the "areas" / "sdkCalls" a child wrapper reported back ------------------------------ //
+void readAreas(const nlohmann::json& areas, std::vector<AreaResult>& out);
+void readSdkCalls(const nlohmann::json& calls, std::vector<SdkCall>& out);
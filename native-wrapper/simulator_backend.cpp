@@ -0,0 +1,269 @@
+#include "simulator_backend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+// ---------- Error code the simulator reports for calls the real SDK would reject (bad IDs, out-of-bounds areas) ---------- //
+const int kSimErrorInvalidCall = 1;
+
+const char* kOperationNames[] = {
+    "createScreen", "addProgram", "addArea", "addText", "sendScreen", "adjustTime"
+};
+
+SimOperation parseOperation(const std::string& name) {
+    for (int op = 0; op < static_cast<int>(SimOperation::Count); ++op) {
+        if (name == kOperationNames[op]) {
+            return static_cast<SimOperation>(op);
+        }
+    }
+    throw std::runtime_error("Unknown simulator operation: " + name);
+}
+
+LatencyModel parseLatencyModel(const json& j) {
+    LatencyModel model;
+    std::string distribution = j.value("distribution", "fixed");
+    if (distribution == "fixed") {
+        model.kind = LatencyModel::Kind::Fixed;
+        model.ms = j.value("ms", 0.0);
+    } else if (distribution == "uniform") {
+        model.kind = LatencyModel::Kind::Uniform;
+        model.minMs = j.value("minMs", 0.0);
+        model.maxMs = j.value("maxMs", model.minMs);
+        if (model.minMs > model.maxMs) {
+            throw std::runtime_error("Uniform latency needs minMs <= maxMs");
+        }
+    } else if (distribution == "normal") {
+        model.kind = LatencyModel::Kind::Normal;
+        model.meanMs = j.value("meanMs", 0.0);
+        model.stddevMs = j.value("stddevMs", 0.0);
+        if (model.stddevMs < 0) {
+            throw std::runtime_error("Normal latency needs stddevMs >= 0");
+        }
+    } else if (distribution == "lognormal") {
+        model.kind = LatencyModel::Kind::LogNormal;
+        model.medianMs = j.value("medianMs", 1.0);
+        model.sigma = j.value("sigma", 0.0);
+        if (model.medianMs <= 0 || model.sigma < 0) {
+            throw std::runtime_error("Lognormal latency needs medianMs > 0 and sigma >= 0");
+        }
+    } else {
+        throw std::runtime_error("Unknown latency distribution: " + distribution);
+    }
+    return model;
+}
+
+// ------------------------------ Simulated controller SDK ------------------------------ //
+class SimulatorBackend : public IDisplayBackend {
+public:
+    explicit SimulatorBackend(const SimulatorConfig& config)
+        : config(config), rng(config.seed), injected(config.failures.size(), 0) {}
+
+    std::wstring name() const override { return L"simulator"; }
+
+    int createScreen(int width, int height, int cardType) override {
+        if (simulateCall(SimOperation::CreateScreen)) return -1;
+        if (width <= 0 || height <= 0 || cardType == 0) return fail(kSimErrorInvalidCall);
+        screenWidth = width;
+        screenHeight = height;
+        programCount = 0;
+        areaCount = 0;
+        itemCount = 0;
+        return 0;
+    }
+
+    int addProgram() override {
+        if (simulateCall(SimOperation::AddProgram)) return -1;
+        if (screenWidth == 0) return fail(kSimErrorInvalidCall);
+        return programCount++;
+    }
+
+    int addArea(int programId, int x, int y, int width, int height) override {
+        if (simulateCall(SimOperation::AddArea)) return -1;
+        if (programId < 0 || programId >= programCount || x < 0 || y < 0 ||
+            x + width > screenWidth || y + height > screenHeight) {
+            return fail(kSimErrorInvalidCall);
+        }
+        return areaCount++;
+    }
+
+    int addText(int areaId, const std::wstring& text, int x, const std::wstring& fontName, int fontHeight) override {
+        if (simulateCall(SimOperation::AddText)) return -1;
+        if (areaId < 0 || areaId >= areaCount || text.empty() ||
+            fontName.empty() || fontHeight <= 0 || x < 0) {
+            return fail(kSimErrorInvalidCall);
+        }
+        return itemCount++;
+    }
+
+    int sendScreen(const std::wstring& ipAddress) override {
+        if (simulateCall(SimOperation::SendScreen)) return -1;
+        if (screenWidth == 0 || ipAddress.empty()) return fail(kSimErrorInvalidCall);
+        return 0;
+    }
+
+    bool supportsAdjustTime() const override { return config.supportsAdjustTime; }
+
+    int adjustTime(const std::wstring& ipAddress) override {
+        if (simulateCall(SimOperation::AdjustTime)) return -1;
+        if (ipAddress.empty()) return fail(kSimErrorInvalidCall);
+        return 0;
+    }
+
+    int lastError() override { return lastErrorCode; }
+
+private:
+    int fail(int errorCode) {
+        lastErrorCode = errorCode;
+        return -1;
+    }
+
+    // ---------- Applies scripted failures and sleeps for the sampled latency; returns true if the call fails ---------- //
+    bool simulateCall(SimOperation op) {
+        int opIndex = static_cast<int>(op);
+        uint64_t callNumber = ++callCounts[opIndex];
+
+        // ---------- Scripted calls (trace replay) reproduce the recorded latency and result exactly ---------- //
+        const std::vector<ScriptedCall>& script = config.script[opIndex];
+        if (callNumber <= script.size()) {
+            const ScriptedCall& scripted = script[callNumber - 1];
+            if (scripted.latencyMs > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(scripted.latencyMs));
+            }
+            if (scripted.fails) {
+                lastErrorCode = scripted.errorCode;
+            }
+            return scripted.fails;
+        }
+
+        const FailureRule* triggered = nullptr;
+        for (size_t r = 0; r < config.failures.size() && !triggered; ++r) {
+            const FailureRule& rule = config.failures[r];
+            if (rule.operation != op || (rule.limit != 0 && injected[r] >= rule.limit)) {
+                continue;
+            }
+            bool hit = false;
+            for (uint64_t n : rule.calls) {
+                if (n == callNumber) hit = true;
+            }
+            if (rule.every != 0 && callNumber % rule.every == 0) hit = true;
+            if (rule.probability > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < rule.probability) hit = true;
+            if (hit) {
+                ++injected[r];
+                triggered = &config.failures[r];
+            }
+        }
+
+        double latencyMs = (triggered && triggered->latencyMs >= 0.0)
+            ? triggered->latencyMs
+            : sampleLatency(config.latency[opIndex]);
+        if (latencyMs > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(latencyMs));
+        }
+
+        if (triggered) {
+            lastErrorCode = triggered->errorCode;
+            return true;
+        }
+        return false;
+    }
+
+    double sampleLatency(const LatencyModel& model) {
+        switch (model.kind) {
+            case LatencyModel::Kind::Uniform:
+                return std::uniform_real_distribution<double>(model.minMs, model.maxMs)(rng);
+            case LatencyModel::Kind::Normal:
+                if (model.stddevMs == 0) return std::max(0.0, model.meanMs);
+                return std::max(0.0, std::normal_distribution<double>(model.meanMs, model.stddevMs)(rng));
+            case LatencyModel::Kind::LogNormal:
+                if (model.sigma == 0) return model.medianMs;
+                return std::lognormal_distribution<double>(std::log(model.medianMs), model.sigma)(rng);
+            case LatencyModel::Kind::Fixed:
+            default:
+                return model.ms;
+        }
+    }
+
+    SimulatorConfig config;
+    std::mt19937_64 rng;
+    std::vector<uint64_t> injected;
+    uint64_t callCounts[static_cast<int>(SimOperation::Count)] = {};
+
+    int screenWidth = 0;
+    int screenHeight = 0;
+    int programCount = 0;
+    int areaCount = 0;
+    int itemCount = 0;
+    int lastErrorCode = 0;
+};
+
+} // namespace
+
+// ------------------------------ Loads simulator settings from JSON ------------------------------ //
+SimulatorConfig loadSimulatorConfig(const std::string& path) {
+    SimulatorConfig config;
+    if (path.empty()) {
+        return config;
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open simulator config: " + path);
+    }
+
+    json j;
+    try {
+        j = json::parse(file);
+    } catch (json::exception& e) {
+        throw std::runtime_error("Invalid simulator config " + path + ": " + e.what());
+    }
+
+    config.seed = j.value("seed", config.seed);
+    config.supportsAdjustTime = j.value("supportsAdjustTime", config.supportsAdjustTime);
+
+    // ---------- Latency models: "default" applies to every operation not listed explicitly ---------- //
+    if (j.contains("latency")) {
+        const json& latency = j["latency"];
+        if (latency.contains("default")) {
+            LatencyModel fallback = parseLatencyModel(latency["default"]);
+            for (LatencyModel& model : config.latency) {
+                model = fallback;
+            }
+        }
+        for (auto it = latency.begin(); it != latency.end(); ++it) {
+            if (it.key() != "default") {
+                config.latency[static_cast<int>(parseOperation(it.key()))] = parseLatencyModel(it.value());
+            }
+        }
+    }
+
+    // ---------- Scripted failures ---------- //
+    if (j.contains("failures")) {
+        for (const json& f : j["failures"]) {
+            FailureRule rule;
+            rule.operation = parseOperation(f.value("operation", "sendScreen"));
+            rule.errorCode = f.value("errorCode", rule.errorCode);
+            rule.calls = f.value("calls", std::vector<uint64_t>());
+            rule.every = f.value("every", rule.every);
+            rule.probability = f.value("probability", rule.probability);
+            rule.limit = f.value("limit", rule.limit);
+            rule.latencyMs = f.value("latencyMs", rule.latencyMs);
+            config.failures.push_back(rule);
+        }
+    }
+
+    return config;
+}
+
+std::unique_ptr<IDisplayBackend> createSimulatorBackend(const SimulatorConfig& config) {
+    return std::unique_ptr<IDisplayBackend>(new SimulatorBackend(config));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "display_backend.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------ Simulated SDK operations (index into per-operation tables) ------------------------------ //
+enum class SimOperation {
+    CreateScreen = 0,
+    AddProgram,
+    AddArea,
+    AddText,
+    SendScreen,
+    AdjustTime,
+    Count
+};
+
+// ------------------------------ Latency distribution of one simulated operation ------------------------------ //
+struct LatencyModel {
+    enum class Kind { Fixed, Uniform, Normal, LogNormal };
+    Kind kind = Kind::Fixed;
+    double ms = 0.0;        // Fixed
+    double minMs = 0.0;     // Uniform
+    double maxMs = 0.0;     // Uniform
+    double meanMs = 0.0;    // Normal
+    double stddevMs = 0.0;  // Normal
+    double medianMs = 0.0;  // LogNormal
+    double sigma = 0.0;     // LogNormal
+};
+
+// ------------------------------ Scripted failure: which calls of an operation fail, and with what error code ------------------------------ //
+struct FailureRule {
+    SimOperation operation = SimOperation::SendScreen;
+    int errorCode = 13;
+    std::vector<uint64_t> calls;  // 1-based call numbers that fail
+    uint64_t every = 0;           // every Nth call fails (0 = off)
+    double probability = 0.0;     // random failure chance per call
+    uint64_t limit = 0;           // stop after this many injected failures (0 = unlimited)
+    double latencyMs = -1.0;      // latency override for failing calls (e.g. a 5s timeout), < 0 = keep model
+};
+
+// ------------------------------ Exact outcome of one call, used to replay recorded traces ------------------------------ //
+struct ScriptedCall {
+    double latencyMs = 0.0;
+    bool fails = false;
+    int errorCode = 0;
+};
+
+// ------------------------------ Complete simulator configuration (from --sim-config=<file.json>) ------------------------------ //
+struct SimulatorConfig {
+    uint64_t seed = 1;
+    bool supportsAdjustTime = true;
+    LatencyModel latency[static_cast<int>(SimOperation::Count)];
+    std::vector<FailureRule> failures;
+    std::vector<ScriptedCall> script[static_cast<int>(SimOperation::Count)];  // call N uses script[N-1], overrides models and rules
+};
+
+// ------------------------------ Loads a simulator configuration, throws std::runtime_error on bad input ------------------------------ //
+SimulatorConfig loadSimulatorConfig(const std::string& path);
+
+// ------------------------------ In-memory Hd_* implementation, no controller or library needed ------------------------------ //
+std::unique_ptr<IDisplayBackend> createSimulatorBackend(const SimulatorConfig& config);
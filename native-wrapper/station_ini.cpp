@@ -0,0 +1,193 @@
+#include "station_ini.hpp"
+
+#include <map>
+#include <sstream>
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+bool startsWith(const std::string& s, const std::string& prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// ---------- parseInt semantics: leading integer, anything unparsable becomes null (NaN in JS) ---------- //
+json parseIntValue(const std::string& value) {
+    try {
+        return std::stoi(value);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+// ---------- "13, 14" -> [13, 14] ---------- //
+json parseCodeList(const std::string& value) {
+    json codes = json::array();
+    std::istringstream parts(value);
+    std::string part;
+    while (std::getline(parts, part, ',')) {
+        json code = parseIntValue(trim(part));
+        if (!code.is_null()) codes.push_back(code);
+    }
+    return codes;
+}
+
+// ---------- INI key -> config field; `numeric` fields go through parseInt ---------- //
+struct FieldMapping {
+    const char* iniKey;
+    const char* field;
+    bool numeric;
+};
+
+const FieldMapping kConfigFields[] = {
+    { "DisplayIPAddress", "displayIpAddress", false },
+    { "GasStationLogo", "gasStationLogo", false },
+    { "NumberOfFuelTypes", "numberOfFuelTypes", true },
+    { "TimeDisplayIPAddress", "timeDisplayIpAddress", false },
+    { "AdjustTime", "adjustTime", false },
+    { "TimeSyncTimeoutMs", "timeSyncTimeoutMs", true },
+    { "ScreenWidth", "screenWidth", true },
+    { "ScreenHeight", "screenHeight", true },
+    { "CardType", "cardType", false },
+    { "RowColumn", "rowColumn", false },
+    { "DoubleSided", "doubleSided", false },
+    { "FontName", "fontName", false },
+    { "FontHeight", "fontHeight", true },
+    { "DecimalFontHeight", "decimalFontHeight", true },
+    { "AutoFitFont", "autoFitFont", false },
+    { "PriceDecimals", "priceDecimals", true },
+    { "DecimalSeparator", "decimalSeparator", false },
+    { "GroupSeparator", "groupSeparator", false },
+    { "CurrencySymbol", "currencySymbol", false },
+    { "CurrencyBefore", "currencyBefore", false },
+    { "GridRows", "gridRows", true },
+    { "GridColumns", "gridColumns", true },
+    { "GridCellSizes", "gridCellSizes", false },
+    { "GridGapX", "gridGapX", true },
+    { "GridGapY", "gridGapY", true },
+    { "GridCellItems", "gridCellItems", false },
+    { "GridSecondSide", "gridSecondSide", false },
+    { "MaxParallelDisplays", "maxParallelDisplays", true },
+    { "RetryMaxAttempts", "retryMaxAttempts", true },
+    { "RetryBaseDelayMs", "retryBaseDelayMs", true },
+    { "RetryMaxDelayMs", "retryMaxDelayMs", true },
+    { "RetryDeadlineMs", "retryDeadlineMs", true },
+};
+
+const FieldMapping kDisplayFields[] = {
+    { "IPAddress", "displayIpAddress", false },
+    { "ScreenWidth", "screenWidth", true },
+    { "ScreenHeight", "screenHeight", true },
+    { "CardType", "cardType", false },
+    { "RowColumn", "rowColumn", false },
+    { "DoubleSided", "doubleSided", false },
+    { "FontName", "fontName", false },
+    { "FontHeight", "fontHeight", true },
+    { "DecimalFontHeight", "decimalFontHeight", true },
+    { "AutoFitFont", "autoFitFont", false },
+    { "PriceDecimals", "priceDecimals", true },
+    { "DecimalSeparator", "decimalSeparator", false },
+    { "GroupSeparator", "groupSeparator", false },
+    { "CurrencySymbol", "currencySymbol", false },
+    { "CurrencyBefore", "currencyBefore", false },
+    { "GridRows", "gridRows", true },
+    { "GridColumns", "gridColumns", true },
+    { "GridCellSizes", "gridCellSizes", false },
+    { "GridGapX", "gridGapX", true },
+    { "GridGapY", "gridGapY", true },
+    { "GridCellItems", "gridCellItems", false },
+    { "GridSecondSide", "gridSecondSide", false },
+};
+
+// ---------- Display<N><Field> keys for extra displays ---------- //
+bool parseDisplayKey(const std::string& key, const std::string& value, std::map<int, json>& displays) {
+    if (!startsWith(key, "Display")) return false;
+    size_t digitsEnd = 7;
+    while (digitsEnd < key.size() && isdigit(static_cast<unsigned char>(key[digitsEnd]))) ++digitsEnd;
+    if (digitsEnd == 7) return false;
+
+    std::string field = key.substr(digitsEnd);
+    for (const FieldMapping& mapping : kDisplayFields) {
+        if (field == mapping.iniKey) {
+            int displayNumber = std::stoi(key.substr(7, digitsEnd - 7));
+            displays[displayNumber][mapping.field] = mapping.numeric ? parseIntValue(value) : json(value);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+json parseStationIni(const std::string& content) {
+    json config = json::object();
+    json fuelNames = json::array();
+    std::map<int, json> displays;
+
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string trimmedLine = trim(line);
+        if (trimmedLine.empty() || trimmedLine[0] == '#' || trimmedLine[0] == ';') {
+            continue;
+        }
+
+        size_t equals = trimmedLine.find('=');
+        if (equals == std::string::npos || equals == 0) continue;
+
+        std::string key = trim(trimmedLine.substr(0, equals));
+        std::string value = trim(trimmedLine.substr(equals + 1));
+
+        // Inline comments and surrounding quotes
+        size_t comment = value.find(';');
+        if (comment != std::string::npos) {
+            value = trim(value.substr(0, comment));
+        }
+        if (value.size() >= 2 && ((value.front() == '"' && value.back() == '"') || (value.front() == '\'' && value.back() == '\''))) {
+            value = value.substr(1, value.size() - 2);
+        }
+
+        bool matched = false;
+        for (const FieldMapping& mapping : kConfigFields) {
+            if (key == mapping.iniKey) {
+                config[mapping.field] = mapping.numeric ? parseIntValue(value) : json(value);
+                matched = true;
+                break;
+            }
+        }
+        if (matched) continue;
+
+        if (key == "RetryableErrorCodes") {
+            config["retryableErrorCodes"] = parseCodeList(value);
+        } else if (key == "ConfigurationErrorCodes") {
+            config["configurationErrorCodes"] = parseCodeList(value);
+        } else if (startsWith(key, "Fuel") && endsWith(key, "Name")) {
+            fuelNames.push_back(value);
+        } else {
+            parseDisplayKey(key, value, displays);
+        }
+    }
+
+    if (!fuelNames.empty()) {
+        config["fuelNames"] = fuelNames;
+    }
+    if (!displays.empty()) {
+        json displayArray = json::array();
+        for (auto& entry : displays) {
+            displayArray.push_back(entry.second);
+        }
+        config["displays"] = displayArray;
+    }
+    return config;
+}
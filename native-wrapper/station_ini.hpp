@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include "json.hpp"
+
+// ------------------------------ Parses a station .ini into the same Config shape as parseIniContent (dataService.ts) ------------------------------ //
+// Keys become camelCase config fields (DisplayIPAddress -> displayIpAddress, ...), FuelNNName entries are collected
+// into "fuelNames" and Display<N>* keys into the "displays" array.
+nlohmann::json parseStationIni(const std::string& content);
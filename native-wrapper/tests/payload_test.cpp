@@ -0,0 +1,113 @@
+// ------------------------------ payload_test - readPayloadCommand key order, run by ctest ------------------------------ //
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../json.hpp"
+#include "../payload.hpp"
+
+using ordered_json = nlohmann::ordered_json;
+
+namespace {
+
+int failures = 0;
+
+void fail(const std::string& what) {
+    std::cerr << "FAIL: " << what << std::endl;
+    ++failures;
+}
+
+ordered_json config() {
+    return {
+        {"displayIpAddress", "10.0.0.1"}, {"cardType", "E63"}, {"fontName", "DejaVu Sans"},
+        {"screenWidth", 128}, {"screenHeight", 64}, {"fontHeight", 32}, {"adjustTime", "N"},
+    };
+}
+
+ordered_json displays() {
+    return ordered_json::array({
+        {{"displayIpAddress", "10.0.0.2"}, {"fontHeight", 24}},
+        {{"screenWidth", 96}, {"displayIpAddress", "10.0.0.3"}, {"decimalFontHeight", 12}, {"decimalSeparator", ","}},
+    });
+}
+
+ordered_json fuelItems() {
+    return ordered_json::array({ {{"name", "Diesel"}, {"price", 1.459}} });
+}
+
+// ---------- The root object with its keys in the given order ---------- //
+ordered_json payload(const std::vector<std::string>& order) {
+    ordered_json root = ordered_json::object();
+    for (const std::string& key : order) {
+        if (key == "config") root[key] = config();
+        else if (key == "displays") root[key] = displays();
+        else root[key] = fuelItems();
+    }
+    return root;
+}
+
+std::string describe(const DisplayConfig& d) {
+    return d.displayIpAddress + " " + d.cardType + " " + d.fontName + " " + std::to_string(d.screenWidth) + "x" +
+           std::to_string(d.screenHeight) + " font " + std::to_string(d.fontHeight) + "/" + std::to_string(d.decimalFontHeight) +
+           " sep " + std::to_string(static_cast<int>(d.priceFormat.decimalSeparator)) + " wide " +
+           std::to_string(d.wideIpAddress.size()) + "/" + std::to_string(d.wideFontName.size());
+}
+
+void expectDisplays(const std::string& name, const Payload& parsed, const std::vector<std::string>& expected) {
+    if (parsed.displays.size() != expected.size()) {
+        fail(name + ": " + std::to_string(parsed.displays.size()) + " displays, expected " + std::to_string(expected.size()));
+        return;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        std::string actual = describe(parsed.displays[i]);
+        if (actual != expected[i]) fail(name + ": display " + std::to_string(i) + " is '" + actual + "', expected '" + expected[i] + "'");
+    }
+}
+
+void expectError(const std::string& name, const std::string& bytes, const std::string& expected) {
+    try {
+        readPayloadCommand(bytes);
+        fail(name + ": accepted");
+    } catch (const std::runtime_error& e) {
+        if (e.what() != expected) fail(name + ": '" + e.what() + "', expected '" + expected + "'");
+    }
+}
+
+} // namespace
+
+int main() {
+    // ---------- Extra displays inherit from "config" wherever it stands ---------- //
+    const std::vector<std::string> expected = {
+        "10.0.0.1 E63 DejaVu Sans 128x64 font 32/32 sep 46 wide 8/11",
+        "10.0.0.2 E63 DejaVu Sans 128x64 font 24/24 sep 46 wide 8/11",
+        "10.0.0.3 E63 DejaVu Sans 96x64 font 32/12 sep 44 wide 8/11",
+    };
+    const std::vector<std::vector<std::string>> orders = {
+        { "config", "displays", "fuelItems" },
+        { "displays", "config", "fuelItems" },
+        { "displays", "fuelItems", "config" },
+        { "fuelItems", "displays", "config" },
+    };
+    for (const std::vector<std::string>& order : orders) {
+        std::string name = order[0] + "," + order[1] + "," + order[2];
+        try {
+            expectDisplays(name + " (json)", readPayloadCommand(payload(order).dump()).payload, expected);
+            std::vector<uint8_t> packed = ordered_json::to_msgpack(payload(order));
+            expectDisplays(name + " (msgpack)", readPayloadCommand(std::string(packed.begin(), packed.end()), PayloadFormat::MessagePack).payload, expected);
+        } catch (const std::exception& e) {
+            fail(name + " threw: " + e.what());
+        }
+    }
+
+    // ---------- Displays read before "config" still report their own path ---------- //
+    expectError("bad field", "{\"displays\":[{\"displayIpAddress\":\"10.0.0.2\",\"screenWidth\":\"wide\"}],\"config\":" + config().dump() + "}",
+                "$.displays[0].screenWidth: expected an integer, got a string");
+    expectError("missing IP", "{\"displays\":[{\"fontHeight\":24}],\"config\":" + config().dump() + "}",
+                "$.displays[0].displayIpAddress: missing");
+    expectError("missing config", "{\"displays\":" + displays().dump() + ",\"fuelItems\":" + fuelItems().dump() + "}",
+                "$.config: missing");
+
+    if (failures == 0) std::cout << "payload_test: all passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+// ------------------------------ price_format_test - parsePriceMills / formatPrice, run by ctest ------------------------------ //
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../price_format.hpp"
+
+namespace {
+
+int failures = 0;
+
+void fail(const std::string& what) {
+    std::cerr << "FAIL: " << what << std::endl;
+    ++failures;
+}
+
+std::string narrow(const std::wstring& text) {
+    std::string out;
+    for (wchar_t c : text) out.push_back(static_cast<char>(c));
+    return out;
+}
+
+// ---------- `text` shown with `decimals` decimals ---------- //
+void expectShown(const std::string& text, int decimals, const std::string& expected) {
+    PriceFormat format;
+    format.decimals = decimals;
+    FormattedPrice formatted;
+    try {
+        formatPrice(parsePriceMills(text), format, formatted);
+    } catch (const std::exception& e) {
+        fail("'" + text + "' threw: " + e.what());
+        return;
+    }
+    std::string shown = narrow(formatted.integerText() + formatted.fractionText());
+    if (shown != expected) fail("'" + text + "' with " + std::to_string(decimals) + " decimals shows " + shown + ", expected " + expected);
+}
+
+void expectRejected(const std::string& text) {
+    try {
+        int64_t mills = parsePriceMills(text);
+        fail("'" + text + "' was accepted as " + std::to_string(mills) + " mills");
+    } catch (const std::runtime_error&) {
+    }
+}
+
+} // namespace
+
+int main() {
+    // ---------- Exact mills round once, half away from zero ---------- //
+    expectShown("11.49", 2, "11.49");
+    expectShown("1.004", 2, "1.00");
+    expectShown("1.005", 2, "1.01");
+    expectShown("-1.005", 2, "-1.01");
+    expectShown("1.005", 3, "1.005");
+    expectShown("1.0040", 2, "1.00");
+    expectShown("1.5e2", 2, "150.00");
+    expectShown("0.0050e1", 3, "0.050");
+
+    // ---------- Digits below a mill would be rounded twice (1.0045 -> 1.005 -> 1.01) ---------- //
+    for (int last = 1; last <= 9; ++last) {
+        expectRejected("1.004" + std::to_string(last));
+    }
+    expectRejected("0.0001");
+    expectRejected("1e-4");
+    expectRejected("abc");
+
+    if (failures == 0) std::cout << "price_format_test: all passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+# ------------------------------ replay_fan_out_test - a recorded two-display send replays the same SDK calls ------------------------------ #
+#   cmake -DWRAPPER=<dll_wrapper> -DWORK_DIR=<scratch directory> -P replay_fan_out_test.cmake
+# The fan-out records each display to <trace>.display<N> and the time sync to <trace>.timesync; the replay has to
+# script and compare every one of them, on the simulator.
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+set(trace "${WORK_DIR}/fan-out.bin")
+file(WRITE "${WORK_DIR}/payload.json"
+    "{\"config\":{\"displayIpAddress\":\"10.0.0.1\",\"cardType\":\"E63\",\"fontName\":\"DejaVu Sans\",\"rowColumn\":\"R\","
+    "\"doubleSided\":\"Y\",\"screenWidth\":128,\"screenHeight\":64,\"fontHeight\":32,\"decimalFontHeight\":16,"
+    "\"timeDisplayIpAddress\":\"10.0.0.9\",\"adjustTime\":\"Y\"},"
+    "\"displays\":[{\"displayIpAddress\":\"10.0.0.2\",\"rowColumn\":\"C\"}],"
+    "\"fuelItems\":[{\"name\":\"D\",\"price\":11.49},{\"name\":\"B\",\"price\":1.75}]}\n")
+
+execute_process(
+    COMMAND "${WRAPPER}" --quiet --backend=simulator "--record=${trace}"
+    INPUT_FILE "${WORK_DIR}/payload.json"
+    OUTPUT_VARIABLE recordOutput
+    RESULT_VARIABLE recordExit)
+if(NOT recordExit EQUAL 0)
+    message(FATAL_ERROR "Recording failed (${recordExit}): ${recordOutput}")
+endif()
+
+execute_process(
+    COMMAND "${WRAPPER}" --quiet "--replay=${trace}"
+    OUTPUT_VARIABLE replayOutput
+    RESULT_VARIABLE replayExit)
+if(NOT replayExit EQUAL 0 OR NOT replayOutput MATCHES "\"mismatches\":0[,}]")
+    message(FATAL_ERROR "Replay did not match the recording (${replayExit}): ${replayOutput}")
+endif()
+
+# ---------- Every side trace was replayed call for call ---------- #
+foreach(suffix display0 display1 timesync)
+    if(NOT replayOutput MATCHES "\"trace\":\"[^\"]*\\.${suffix}\",\"calls\":([0-9]+),\"replayedCalls\":([0-9]+)")
+        message(FATAL_ERROR "Replay did not use ${trace}.${suffix}: ${replayOutput}")
+    endif()
+    if(CMAKE_MATCH_1 EQUAL 0 OR NOT CMAKE_MATCH_1 EQUAL CMAKE_MATCH_2)
+        message(FATAL_ERROR "${suffix}: ${CMAKE_MATCH_1} recorded call(s), ${CMAKE_MATCH_2} replayed: ${replayOutput}")
+    endif()
+endforeach()
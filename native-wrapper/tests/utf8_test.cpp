@@ -0,0 +1,149 @@
+// ------------------------------ utf8_test - utf8ToWide / widen / wideToUtf8, run by ctest ------------------------------ //
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../utf8.hpp"
+
+namespace {
+
+int failures = 0;
+
+void fail(const std::string& what) {
+    std::cerr << "FAIL: " << what << std::endl;
+    ++failures;
+}
+
+std::string hex(const std::string& bytes) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : bytes) {
+        if (!out.empty()) out += ' ';
+        out += digits[c >> 4];
+        out += digits[c & 0x0F];
+    }
+    return out;
+}
+
+// ---------- The wide string a code point sequence should decode to (surrogate pairs where wchar_t is 16 bits) ---------- //
+std::wstring wide(const std::vector<uint32_t>& codePoints) {
+    std::wstring out;
+    for (uint32_t cp : codePoints) {
+        if (sizeof(wchar_t) == 2 && cp > 0xFFFF) {
+            cp -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            out.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+    return out;
+}
+
+std::wstring asciiWide(const std::string& ascii) {
+    return std::wstring(ascii.begin(), ascii.end());
+}
+
+void expectDecoded(const std::string& bytes, const std::wstring& expected) {
+    std::wstring decoded;
+    try {
+        decoded = utf8ToWide(bytes);
+    } catch (const std::exception& e) {
+        fail("[" + hex(bytes) + "] threw: " + e.what());
+        return;
+    }
+    if (decoded != expected) fail("[" + hex(bytes) + "] decoded to " + std::to_string(decoded.size()) + " unexpected character(s)");
+    if (wideToUtf8(decoded) != bytes) fail("[" + hex(bytes) + "] does not round-trip through wideToUtf8");
+    if (widen(bytes) != expected) fail("[" + hex(bytes) + "] widens differently than it decodes");
+}
+
+// ---------- Rejected by the strict decoder at `badByte`, while widen() puts U+FFFD there ---------- //
+void expectRejected(const std::string& bytes, size_t badByte) {
+    try {
+        std::wstring decoded = utf8ToWide(bytes);
+        fail("[" + hex(bytes) + "] was accepted as " + std::to_string(decoded.size()) + " character(s)");
+    } catch (const std::runtime_error& e) {
+        std::string expected = "invalid UTF-8 at byte " + std::to_string(badByte);
+        if (e.what() != expected) fail("[" + hex(bytes) + "] reported '" + e.what() + "', expected '" + expected + "'");
+    }
+
+    std::wstring lenient = widen(bytes);
+    if (lenient.size() <= badByte || lenient[badByte] != static_cast<wchar_t>(0xFFFD)) {
+        fail("[" + hex(bytes) + "] widen() has no U+FFFD at " + std::to_string(badByte));
+    }
+}
+
+} // namespace
+
+int main() {
+    // ---------- ASCII around the 16-byte SSE2 blocks, alone and followed by a multi-byte character ---------- //
+    for (size_t length = 0; length <= 40; ++length) {
+        std::string ascii;
+        for (size_t i = 0; i < length; ++i) ascii += static_cast<char>('!' + (i * 7) % 94);
+        expectDecoded(ascii, asciiWide(ascii));
+        expectDecoded(ascii + "\xC3\xA9" "x", asciiWide(ascii) + wide({ 0xE9, 'x' }));
+        expectDecoded("\xE2\x82\xAC" + ascii, wide({ 0x20AC }) + asciiWide(ascii));
+    }
+
+    // ---------- Every sequence length, at its limits ---------- //
+    expectDecoded("\xC2\x80", wide({ 0x80 }));
+    expectDecoded("\xDF\xBF", wide({ 0x7FF }));
+    expectDecoded("\xE0\xA0\x80", wide({ 0x800 }));
+    expectDecoded("\xED\x9F\xBF", wide({ 0xD7FF }));
+    expectDecoded("\xEE\x80\x80", wide({ 0xE000 }));
+    expectDecoded("\xEF\xBF\xBF", wide({ 0xFFFF }));
+    expectDecoded("\xF0\x90\x80\x80", wide({ 0x10000 }));
+    expectDecoded("\xF4\x8F\xBF\xBF", wide({ 0x10FFFF }));
+
+    // ---------- 4-byte sequences: a surrogate pair with 16-bit wchar_t, also across a block boundary ---------- //
+    expectDecoded("\xF0\x9F\x98\x80", wide({ 0x1F600 }));
+    expectDecoded(std::string(14, 'a') + "\xF0\x9F\x98\x80" + std::string(14, 'b'),
+                  asciiWide(std::string(14, 'a')) + wide({ 0x1F600 }) + asciiWide(std::string(14, 'b')));
+
+    // ---------- Overlong forms ---------- //
+    expectRejected("\xC0\xAF", 0);
+    expectRejected("\xC1\xBF", 0);
+    expectRejected("\xE0\x80\xAF", 0);
+    expectRejected("\xE0\x9F\xBF", 0);
+    expectRejected("\xF0\x80\x80\xAF", 0);
+    expectRejected("\xF0\x8F\xBF\xBF", 0);
+
+    // ---------- UTF-16 surrogates and code points above U+10FFFF ---------- //
+    expectRejected("\xED\xA0\x80", 0);
+    expectRejected("\xED\xBF\xBF", 0);
+    expectRejected("\xED\xA0\xBD\xED\xB8\x80", 0);
+    expectRejected("\xF4\x90\x80\x80", 0);
+    expectRejected("\xF5\x80\x80\x80", 0);
+    expectRejected("\xFF", 0);
+
+    // ---------- Truncated sequences and stray continuation bytes ---------- //
+    expectRejected("\xC3", 0);
+    expectRejected("\xE2\x82", 0);
+    expectRejected("\xF0\x9F\x98", 0);
+    expectRejected("\xE2\x28\xA1", 0);
+    expectRejected("\xF0\x9F\x98" "a", 0);
+    expectRejected("\x80", 0);
+    expectRejected("ab\xBF" "cd", 2);
+
+    // ---------- The offset counts bytes, past SSE2 blocks and earlier multi-byte characters ---------- //
+    expectRejected(std::string(16, 'a') + "\xC0\xAF", 16);
+    expectRejected(std::string(20, 'a') + "\xE2\x82", 20);
+    expectRejected("\xC3\xA9" + std::string(31, 'a') + "\xED\xA0\x80", 33);
+
+    // ---------- A reused buffer holds only the latest string ---------- //
+    std::wstring buffer;
+    utf8ToWide(std::string(40, 'x'), buffer);
+    utf8ToWide(std::string("\xE2\x82\xAC" "1"), buffer);
+    if (buffer != wide({ 0x20AC, '1' })) fail("reused buffer kept characters of the previous string");
+    try {
+        utf8ToWide(std::string("\xC0\xAF"), buffer);
+        fail("reused buffer: overlong form was accepted");
+    } catch (const std::runtime_error&) {
+        if (!buffer.empty()) fail("reused buffer is not empty after a rejected string");
+    }
+
+    if (failures == 0) std::cout << "utf8_test: all passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
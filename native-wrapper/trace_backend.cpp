@@ -0,0 +1,498 @@
+#include "trace_backend.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include "log.hpp"
+#include "result_channel.hpp"
+#include "utf8.hpp"
+
+namespace {
+
+const char kTraceMagic[4] = { 'H', 'D', 'T', 'R' };
+const uint8_t kTraceVersion = 1;
+
+const wchar_t* kTraceOpNames[] = {
+    L"Hd_CreateScreen", L"Hd_AddProgram", L"Hd_AddArea", L"Hd_AddSimpleTextAreaItem",
+    L"Hd_SendScreen", L"Cmd_AdjustTime", L"Hd_GetSDKLastError", L"Payload"
+};
+
+// ---------- Arguments each operation is recorded with; replay relies on them ---------- //
+struct TraceOpArity {
+    uint64_t ints;
+    uint64_t strings;
+};
+
+const TraceOpArity kTraceOpArity[] = {
+    { 3, 0 }, { 0, 0 }, { 5, 0 }, { 3, 2 }, { 0, 1 }, { 0, 1 }, { 0, 0 }, { 0, 1 }
+};
+static_assert(sizeof(kTraceOpArity) / sizeof(kTraceOpArity[0]) == static_cast<size_t>(TraceOp::Payload) + 1,
+              "one arity per TraceOp");
+
+// ------------------------------ Varint / zigzag encoding ------------------------------ //
+void writeVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void writeZigzag(std::string& out, int64_t value) {
+    writeVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+uint64_t readVarint(std::istream& in) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF) throw std::runtime_error("Truncated trace record");
+        value |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if (!(c & 0x80)) return value;
+    }
+    throw std::runtime_error("Malformed varint in trace");
+}
+
+int64_t readZigzag(std::istream& in) {
+    uint64_t raw = readVarint(in);
+    return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+}
+
+// ---------- Whether a return value means the call failed (Hd_* conventions) ---------- //
+bool isFailure(TraceOp op, int64_t ret) {
+    switch (op) {
+        case TraceOp::CreateScreen:
+        case TraceOp::SendScreen:
+        case TraceOp::AdjustTime:
+            return ret != 0;
+        case TraceOp::AddProgram:
+        case TraceOp::AddArea:
+        case TraceOp::AddText:
+            return ret == -1;
+        default:
+            return false;
+    }
+}
+
+uint64_t microsSince(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+// ------------------------------ Recording decorator ------------------------------ //
+class RecordingBackend : public IDisplayBackend {
+public:
+    RecordingBackend(std::unique_ptr<IDisplayBackend> inner, TraceSink sink)
+        : inner(std::move(inner)), sink(std::move(sink)), traceStart(std::chrono::steady_clock::now()) {}
+
+    std::wstring name() const override { return inner->name() + L"+recording"; }
+
+    void beginCommand(const std::string& payload) override {
+        TraceRecord record;
+        record.op = TraceOp::Payload;
+        record.startUs = microsSince(traceStart, std::chrono::steady_clock::now());
+        std::wstring raw;
+        raw.reserve(payload.size());
+        for (char c : payload) raw.push_back(static_cast<unsigned char>(c));
+        record.strings.push_back(raw);
+        sink(record);
+        inner->beginCommand(payload);
+    }
+
+    int createScreen(int width, int height, int cardType) override {
+        return record(TraceOp::CreateScreen, { width, height, cardType }, {},
+                      [&] { return inner->createScreen(width, height, cardType); });
+    }
+
+    int addProgram() override {
+        return record(TraceOp::AddProgram, {}, {}, [&] { return inner->addProgram(); });
+    }
+
+    int addArea(int programId, int x, int y, int width, int height) override {
+        return record(TraceOp::AddArea, { programId, x, y, width, height }, {},
+                      [&] { return inner->addArea(programId, x, y, width, height); });
+    }
+
+    int addText(int areaId, const std::wstring& text, int x, const std::wstring& fontName, int fontHeight) override {
+        return record(TraceOp::AddText, { areaId, x, fontHeight }, { text, fontName },
+                      [&] { return inner->addText(areaId, text, x, fontName, fontHeight); });
+    }
+
+    int sendScreen(const std::wstring& ipAddress) override {
+        return record(TraceOp::SendScreen, {}, { ipAddress }, [&] { return inner->sendScreen(ipAddress); });
+    }
+
+    bool supportsAdjustTime() const override { return inner->supportsAdjustTime(); }
+
+    int adjustTime(const std::wstring& ipAddress) override {
+        return record(TraceOp::AdjustTime, {}, { ipAddress }, [&] { return inner->adjustTime(ipAddress); });
+    }
+
+    int lastError() override {
+        return record(TraceOp::LastError, {}, {}, [&] { return inner->lastError(); });
+    }
+
+private:
+    template <typename Call>
+    int record(TraceOp op, std::vector<int64_t> ints, std::vector<std::wstring> strings, Call call) {
+        auto start = std::chrono::steady_clock::now();
+        int ret = call();
+        auto end = std::chrono::steady_clock::now();
+
+        TraceRecord record;
+        record.op = op;
+        record.startUs = microsSince(traceStart, start);
+        record.durationUs = microsSince(start, end);
+        record.ret = ret;
+        record.ints = std::move(ints);
+        record.strings = std::move(strings);
+        sink(record);
+        return ret;
+    }
+
+    std::unique_ptr<IDisplayBackend> inner;
+    TraceSink sink;
+    std::chrono::steady_clock::time_point traceStart;
+};
+
+// ------------------------------ Per-operation replay statistics ------------------------------ //
+struct OpStats {
+    uint64_t calls = 0;
+    uint64_t originalUs = 0;
+    uint64_t replayUs = 0;
+    uint64_t resultMismatches = 0;
+};
+
+struct CallComparison {
+    std::map<int, OpStats> stats;
+    uint64_t originalGapUs = 0;
+    uint64_t replayGapUs = 0;
+    uint64_t structuralMismatches = 0;
+};
+
+// ---------- The simulator script that reproduces the recorded latency and outcome of every call ---------- //
+SimulatorConfig scriptFromTrace(const std::vector<TraceRecord>& records) {
+    SimulatorConfig simConfig;
+    for (size_t r = 0; r < records.size(); ++r) {
+        const TraceRecord& record = records[r];
+        if (record.op == TraceOp::Payload || record.op == TraceOp::LastError) {
+            continue;
+        }
+
+        ScriptedCall scripted;
+        scripted.latencyMs = record.durationUs / 1000.0;
+        scripted.fails = isFailure(record.op, record.ret);
+        if (scripted.fails && r + 1 < records.size() && records[r + 1].op == TraceOp::LastError) {
+            scripted.errorCode = static_cast<int>(records[r + 1].ret);
+        }
+        simConfig.script[static_cast<int>(record.op)].push_back(scripted);
+    }
+    return simConfig;
+}
+
+// ---------- Call by call: SDK time, wrapper time between calls, return codes; calls only one side made are mismatches ---------- //
+void compareCalls(const std::vector<TraceRecord>& original, const std::vector<TraceRecord>& replayed, CallComparison& comparison) {
+    size_t o = 0, p = 0;
+    const TraceRecord* prevOriginal = nullptr;
+    const TraceRecord* prevReplay = nullptr;
+    while (o < original.size() && p < replayed.size()) {
+        if (original[o].op == TraceOp::Payload) { prevOriginal = nullptr; ++o; continue; }
+        if (replayed[p].op == TraceOp::Payload) { prevReplay = nullptr; ++p; continue; }
+
+        const TraceRecord& a = original[o];
+        const TraceRecord& b = replayed[p];
+        if (a.op != b.op) {
+            ++comparison.structuralMismatches;
+            ++o; ++p;
+            continue;
+        }
+
+        OpStats& s = comparison.stats[static_cast<int>(a.op)];
+        ++s.calls;
+        s.originalUs += a.durationUs;
+        s.replayUs += b.durationUs;
+        if (a.ret != b.ret && a.op != TraceOp::AddProgram && a.op != TraceOp::AddArea && a.op != TraceOp::AddText) {
+            ++s.resultMismatches;
+        }
+        if (prevOriginal && prevReplay) {
+            comparison.originalGapUs += a.startUs - (prevOriginal->startUs + prevOriginal->durationUs);
+            comparison.replayGapUs += b.startUs - (prevReplay->startUs + prevReplay->durationUs);
+        }
+        prevOriginal = &a;
+        prevReplay = &b;
+        ++o; ++p;
+    }
+    for (; o < original.size(); ++o) {
+        if (original[o].op != TraceOp::Payload) ++comparison.structuralMismatches;
+    }
+    for (; p < replayed.size(); ++p) {
+        if (replayed[p].op != TraceOp::Payload) ++comparison.structuralMismatches;
+    }
+}
+
+size_t sdkCallCount(const std::vector<TraceRecord>& records) {
+    size_t calls = 0;
+    for (const TraceRecord& record : records) {
+        if (record.op != TraceOp::Payload) ++calls;
+    }
+    return calls;
+}
+
+// ---------- A side trace: the calls a recording wrapper made on another backend instance (fan-out display, time sync) ---------- //
+// The recorder truncates side traces per command, so they hold the last command's calls; so does `replayed`.
+struct SideTrace {
+    std::vector<TraceRecord> original;
+    SimulatorConfig script;
+    std::vector<TraceRecord> replayed;
+};
+
+// ---------- "<trace>.display<N>" and "<trace>.timesync" next to the main trace, by suffix ---------- //
+std::map<std::string, std::unique_ptr<SideTrace>> loadSideTraces(const std::string& path) {
+    std::map<std::string, std::unique_ptr<SideTrace>> sideTraces;
+    std::filesystem::path mainPath(path);
+    std::filesystem::path directory = mainPath.has_parent_path() ? mainPath.parent_path() : std::filesystem::path(".");
+    std::string prefix = mainPath.filename().string() + ".";
+
+    std::error_code ec;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string suffix = name.substr(prefix.size() - 1);
+        bool displayTrace = suffix.size() > 8 && suffix.compare(0, 8, ".display") == 0 &&
+                            suffix.find_first_not_of("0123456789", 8) == std::string::npos;
+        if (!displayTrace && suffix != ".timesync") continue;
+
+        std::unique_ptr<SideTrace> sideTrace(new SideTrace());
+        sideTrace->original = readTraceFile(path + suffix);
+        sideTrace->script = scriptFromTrace(sideTrace->original);
+        WLOG_INFO(L"[REPLAY] Loaded " << sideTrace->original.size() << L" record(s) from " << widen(path + suffix));
+        sideTraces[suffix] = std::move(sideTrace);
+    }
+    return sideTraces;
+}
+
+} // namespace
+
+std::unique_ptr<IDisplayBackend> createRecordingBackend(std::unique_ptr<IDisplayBackend> inner, TraceSink sink) {
+    return std::unique_ptr<IDisplayBackend>(new RecordingBackend(std::move(inner), std::move(sink)));
+}
+
+// ------------------------------ Binary trace writer ------------------------------ //
+TraceSink openTraceFile(const std::string& path) {
+    std::shared_ptr<std::ofstream> file(new std::ofstream(path, std::ios::binary | std::ios::trunc));
+    if (!*file) {
+        throw std::runtime_error("Failed to open trace file for writing: " + path);
+    }
+
+    std::string header(kTraceMagic, sizeof(kTraceMagic));
+    header.push_back(static_cast<char>(kTraceVersion));
+    writeVarint(header, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+    file->write(header.data(), header.size());
+
+    std::shared_ptr<uint64_t> previousStartUs(new uint64_t(0));
+    std::shared_ptr<std::string> buffer(new std::string());
+
+    return [file, previousStartUs, buffer](const TraceRecord& record) {
+        std::string& out = *buffer;
+        out.clear();
+        out.push_back(static_cast<char>(record.op));
+        writeVarint(out, record.startUs - *previousStartUs);
+        writeVarint(out, record.durationUs);
+        writeZigzag(out, record.ret);
+        writeVarint(out, record.ints.size());
+        for (int64_t value : record.ints) {
+            writeZigzag(out, value);
+        }
+        writeVarint(out, record.strings.size());
+        for (const std::wstring& s : record.strings) {
+            writeVarint(out, s.size());
+            for (wchar_t c : s) {
+                writeVarint(out, static_cast<uint32_t>(c));
+            }
+        }
+        *previousStartUs = record.startUs;
+        file->write(out.data(), out.size());
+
+        // Device commands end a send; flush so a crash right after still leaves a usable trace
+        if (record.op == TraceOp::SendScreen || record.op == TraceOp::AdjustTime) {
+            file->flush();
+        }
+    };
+}
+
+// ------------------------------ Binary trace reader ------------------------------ //
+std::vector<TraceRecord> readTraceFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open trace file: " + path);
+    }
+
+    char magic[sizeof(kTraceMagic)];
+    if (!file.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(kTraceMagic, sizeof(kTraceMagic))) {
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+    if (file.get() != kTraceVersion) {
+        throw std::runtime_error("Unsupported trace version in " + path);
+    }
+    readVarint(file); // wall-clock start
+
+    std::vector<TraceRecord> records;
+    uint64_t startUs = 0;
+    int op;
+    while ((op = file.get()) != EOF) {
+        if (op > static_cast<int>(TraceOp::Payload)) {
+            throw std::runtime_error("Unknown trace operation " + std::to_string(op));
+        }
+        TraceRecord record;
+        record.op = static_cast<TraceOp>(op);
+        startUs += readVarint(file);
+        record.startUs = startUs;
+        record.durationUs = readVarint(file);
+        record.ret = readZigzag(file);
+        uint64_t intCount = readVarint(file);
+        for (uint64_t i = 0; i < intCount; ++i) {
+            record.ints.push_back(readZigzag(file));
+        }
+        uint64_t stringCount = readVarint(file);
+        for (uint64_t i = 0; i < stringCount; ++i) {
+            uint64_t length = readVarint(file);
+            std::wstring s;
+            s.reserve(length);
+            for (uint64_t c = 0; c < length; ++c) {
+                s.push_back(static_cast<wchar_t>(readVarint(file)));
+            }
+            record.strings.push_back(s);
+        }
+        const TraceOpArity& arity = kTraceOpArity[op];
+        if (intCount != arity.ints || stringCount != arity.strings) {
+            throw std::runtime_error("Malformed trace: " + wideToUtf8(kTraceOpNames[op]) + " record #" + std::to_string(records.size()) +
+                                     " has " + std::to_string(intCount) + " int and " + std::to_string(stringCount) +
+                                     " string argument(s), expected " + std::to_string(arity.ints) + " and " + std::to_string(arity.strings));
+        }
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+// ------------------------------ Trace replay ------------------------------ //
+int replayTrace(const std::string& path, const PayloadRunner& runPayload) {
+    WLOG_INFO(L"\n====================================================================");
+    WLOG_INFO(L"                        TRACE REPLAY                                ");
+    WLOG_INFO(L"====================================================================");
+
+    std::vector<TraceRecord> original = readTraceFile(path);
+    WLOG_INFO(L"[REPLAY] Loaded " << original.size() << L" record(s) from " << widen(path));
+    std::map<std::string, std::unique_ptr<SideTrace>> sideTraces = loadSideTraces(path);
+
+    std::vector<std::string> payloads;
+    for (const TraceRecord& record : original) {
+        if (record.op != TraceOp::Payload) continue;
+        std::string payload;
+        for (wchar_t c : record.strings[0]) payload.push_back(static_cast<char>(c));
+        payloads.push_back(payload);
+    }
+
+    // ---------- Script the simulator with the recorded latency and outcome of every call ---------- //
+    std::vector<TraceRecord> replayed;
+    std::unique_ptr<IDisplayBackend> backend = createRecordingBackend(
+        createSimulatorBackend(scriptFromTrace(original)),
+        [&replayed](const TraceRecord& record) { replayed.push_back(record); });
+
+    // ---------- Fan-out displays and the time sync get a simulator scripted from their side trace ---------- //
+    std::mutex sideMutex;
+    SideBackendFactory sideBackends = [&sideTraces, &sideMutex](const std::string& recordSuffix) {
+        std::lock_guard<std::mutex> lock(sideMutex);
+        std::unique_ptr<SideTrace>& sideTrace = sideTraces[recordSuffix];
+        if (!sideTrace) {
+            // Not recorded: the calls still run, and count as mismatches
+            sideTrace.reset(new SideTrace());
+        }
+        sideTrace->replayed.clear();
+        SideTrace* target = sideTrace.get();
+        return createRecordingBackend(
+            createSimulatorBackend(target->script),
+            [target](const TraceRecord& record) { target->replayed.push_back(record); });
+    };
+
+    // ---------- Re-run: recorded payloads through the normal send path, otherwise call by call ---------- //
+    if (!payloads.empty()) {
+        WLOG_INFO(L"[REPLAY] Re-running " << payloads.size() << L" recorded payload(s)");
+        for (const std::string& payload : payloads) {
+            runPayload(payload, backend, sideBackends);
+        }
+    } else {
+        WLOG_INFO(L"[REPLAY] No payloads in trace - replaying SDK calls directly");
+        for (const TraceRecord& record : original) {
+            const std::vector<int64_t>& a = record.ints;
+            switch (record.op) {
+                case TraceOp::CreateScreen: backend->createScreen((int)a[0], (int)a[1], (int)a[2]); break;
+                case TraceOp::AddProgram: backend->addProgram(); break;
+                case TraceOp::AddArea: backend->addArea((int)a[0], (int)a[1], (int)a[2], (int)a[3], (int)a[4]); break;
+                case TraceOp::AddText: backend->addText((int)a[0], record.strings[0], (int)a[1], record.strings[1], (int)a[2]); break;
+                case TraceOp::SendScreen: backend->sendScreen(record.strings[0]); break;
+                case TraceOp::AdjustTime: backend->adjustTime(record.strings[0]); break;
+                case TraceOp::LastError: backend->lastError(); break;
+                default: break;
+            }
+        }
+    }
+
+    // ---------- Compare each trace with its replay ---------- //
+    CallComparison comparison;
+    compareCalls(original, replayed, comparison);
+    ResultRecord sideTraceResults = ResultRecord::array();
+    for (const auto& entry : sideTraces) {
+        uint64_t mismatchesBefore = comparison.structuralMismatches;
+        compareCalls(entry.second->original, entry.second->replayed, comparison);
+        uint64_t sideMismatches = comparison.structuralMismatches - mismatchesBefore;
+        if (sideMismatches != 0) {
+            WLOG_WARN(L"[REPLAY] [!] " << widen(path + entry.first) << L": " << sideMismatches << L" call(s) only one side made");
+        }
+        sideTraceResults.push_back({
+            { "trace", path + entry.first },
+            { "calls", sdkCallCount(entry.second->original) },
+            { "replayedCalls", sdkCallCount(entry.second->replayed) },
+        });
+    }
+
+    WLOG_INFO(L"\n[REPLAY] Per-call timing (original -> replay, mean us):");
+    ResultRecord operations = ResultRecord::object();
+    uint64_t totalMismatches = comparison.structuralMismatches;
+    for (const auto& entry : comparison.stats) {
+        const OpStats& s = entry.second;
+        double originalMean = static_cast<double>(s.originalUs) / s.calls;
+        double replayMean = static_cast<double>(s.replayUs) / s.calls;
+        WLOG_INFO(L"         " << kTraceOpNames[entry.first] << L": " << s.calls << L" call(s), "
+                  << originalMean << L" -> " << replayMean << L" (overhead " << (replayMean - originalMean) << L")");
+        totalMismatches += s.resultMismatches;
+
+        operations[wideToUtf8(kTraceOpNames[entry.first])] = {
+            { "calls", s.calls },
+            { "originalMeanUs", originalMean },
+            { "replayMeanUs", replayMean },
+            { "resultMismatches", s.resultMismatches },
+        };
+    }
+    WLOG_INFO(L"[REPLAY] Wrapper time between calls: " << comparison.originalGapUs << L" us -> " << comparison.replayGapUs << L" us");
+    if (totalMismatches != 0) {
+        WLOG_WARN(L"[REPLAY] [!] " << totalMismatches << L" call(s) did not match the recording");
+    }
+
+    ResultRecord record;
+    record["success"] = totalMismatches == 0;
+    record["replay"] = {
+        { "records", original.size() },
+        { "payloads", payloads.size() },
+        { "sideTraces", sideTraceResults },
+        { "originalWrapperGapUs", comparison.originalGapUs },
+        { "replayWrapperGapUs", comparison.replayGapUs },
+        { "mismatches", totalMismatches },
+        { "operations", operations },
+    };
+    writeResult(record);
+
+    return totalMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "display_backend.hpp"
+#include "simulator_backend.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------ One recorded SDK call (or command payload) ------------------------------ //
+// Binary trace file layout (all integers little-endian varints, signed values zigzag-encoded):
+//   header:  "HDTR" | u8 version | varint wall-clock start (unix ms)
+//   record:  u8 op | varint start delta (us) | varint duration (us) | zigzag return value
+//            | varint int-arg count | zigzag int args... | varint string count | (varint length | varint code points...)...
+//   Payload records carry the raw command bytes as their single string.
+enum class TraceOp : uint8_t {
+    CreateScreen = 0,
+    AddProgram,
+    AddArea,
+    AddText,
+    SendScreen,
+    AdjustTime,
+    LastError,
+    Payload
+};
+
+struct TraceRecord {
+    TraceOp op = TraceOp::Payload;
+    uint64_t startUs = 0;       // since the start of the trace
+    uint64_t durationUs = 0;
+    int64_t ret = 0;
+    std::vector<int64_t> ints;
+    std::vector<std::wstring> strings;
+};
+
+typedef std::function<void(const TraceRecord&)> TraceSink;
+
+// ------------------------------ Decorator that forwards every call to `inner` and reports it to `sink` ------------------------------ //
+std::unique_ptr<IDisplayBackend> createRecordingBackend(std::unique_ptr<IDisplayBackend> inner, TraceSink sink);
+
+// ------------------------------ Sink that appends records to a binary trace file (--record=<file>) ------------------------------ //
+TraceSink openTraceFile(const std::string& path);
+
+// ------------------------------ Reads a whole trace file, throws std::runtime_error on malformed input ------------------------------ //
+std::vector<TraceRecord> readTraceFile(const std::string& path);
+
+// ------------------------------ Backend for work a command does beside its main backend, by record suffix ------------------------------ //
+// ".display<N>" for fan-out display N, ".timesync" for the time sync; the recorder writes each to <trace><suffix>.
+typedef std::function<std::unique_ptr<IDisplayBackend>(const std::string& recordSuffix)> SideBackendFactory;
+
+// ------------------------------ Replays a trace against the simulator scripted with the recorded latencies and results ------------------------------ //
+// Recorded payloads are fed through `runPayload` (the normal send path), so the report shows both the per-call
+// timings and the wrapper's own overhead between calls. The side traces next to the trace script the backends
+// `runPayload` gets from the factory, and are compared the same way. Traces without payloads are replayed call by call.
+typedef std::function<int(const std::string&, std::unique_ptr<IDisplayBackend>&, const SideBackendFactory&)> PayloadRunner;
+int replayTrace(const std::string& path, const PayloadRunner& runPayload);
@@ -0,0 +1,164 @@
+#include "utf8.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const size_t kInvalid = static_cast<size_t>(-1);
+
+// ---------- One multi-byte sequence at `p`; returns its length, 0 when malformed or truncated ---------- //
+int decodeSequence(const unsigned char* p, size_t available, uint32_t& codePoint) {
+    unsigned char lead = p[0];
+    unsigned char low = 0x80;   // allowed range of the second byte, narrowed against overlongs and surrogates
+    unsigned char high = 0xBF;
+    size_t length = 0;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codePoint = lead & 0x0F;
+        if (lead == 0xE0) low = 0xA0;
+        if (lead == 0xED) high = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codePoint = lead & 0x07;
+        if (lead == 0xF0) low = 0x90;
+        if (lead == 0xF4) high = 0x8F;
+    } else {
+        return 0;
+    }
+    if (available < length || p[1] < low || p[1] > high) {
+        return 0;
+    }
+    codePoint = (codePoint << 6) | (p[1] & 0x3F);
+    for (size_t k = 2; k < length; ++k) {
+        if ((p[k] & 0xC0) != 0x80) return 0;
+        codePoint = (codePoint << 6) | (p[k] & 0x3F);
+    }
+    return static_cast<int>(length);
+}
+
+#ifdef UTF8_USE_SSE2
+// ---------- 16 ASCII bytes -> 16 wide characters ---------- //
+inline void widenAscii16(__m128i chunk, wchar_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i low = _mm_unpacklo_epi8(chunk, zero);
+    __m128i high = _mm_unpackhi_epi8(chunk, zero);
+    if (sizeof(wchar_t) == 2) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), high);
+    } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+    }
+}
+#endif
+
+// ---------- Decodes into `out` (room for `size` characters, never exceeded); returns the count or kInvalid ---------- //
+// With `replace`, malformed bytes become U+FFFD one byte at a time; otherwise `badOffset` gets the first one.
+size_t decode(const unsigned char* in, size_t size, wchar_t* out, bool replace, size_t& badOffset) {
+    size_t i = 0;
+    size_t o = 0;
+    while (i < size) {
+#ifdef UTF8_USE_SSE2
+        while (i + 16 <= size) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            if (_mm_movemask_epi8(chunk) != 0) break;
+            widenAscii16(chunk, out + o);
+            i += 16;
+            o += 16;
+        }
+        if (i == size) break;
+#endif
+        unsigned char lead = in[i];
+        if (lead < 0x80) {
+            out[o++] = static_cast<wchar_t>(lead);
+            ++i;
+            continue;
+        }
+
+        uint32_t codePoint = 0;
+        int length = decodeSequence(in + i, size - i, codePoint);
+        if (length == 0) {
+            if (!replace) {
+                badOffset = i;
+                return kInvalid;
+            }
+            out[o++] = static_cast<wchar_t>(0xFFFD);
+            ++i;
+            continue;
+        }
+        // A 4-byte sequence needs 2 UTF-16 units, so the output never outgrows the input
+        if (sizeof(wchar_t) == 2 && codePoint > 0xFFFF) {
+            codePoint -= 0x10000;
+            out[o++] = static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+            out[o++] = static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+        } else {
+            out[o++] = static_cast<wchar_t>(codePoint);
+        }
+        i += length;
+    }
+    return o;
+}
+
+} // namespace
+
+void utf8ToWide(const char* data, size_t size, std::wstring& out) {
+    out.resize(size);
+    size_t badOffset = 0;
+    size_t length = decode(reinterpret_cast<const unsigned char*>(data), size, &out[0], false, badOffset);
+    if (length == kInvalid) {
+        out.clear();
+        throw std::runtime_error("invalid UTF-8 at byte " + std::to_string(badOffset));
+    }
+    out.resize(length);
+}
+
+std::wstring widen(const std::string& text) {
+    std::wstring out(text.size(), L'\0');
+    size_t badOffset = 0;
+    out.resize(decode(reinterpret_cast<const unsigned char*>(text.data()), text.size(), &out[0], true, badOffset));
+    return out;
+}
+
+std::string wideToUtf8(const std::wstring& wide) {
+    std::string text;
+    text.reserve(wide.size());
+    for (size_t i = 0; i < wide.size(); ++i) {
+        uint32_t codePoint = static_cast<uint32_t>(wide[i]);
+        if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint < 0xE000) {
+            uint32_t next = i + 1 < wide.size() ? static_cast<uint32_t>(wide[i + 1]) : 0;
+            if (codePoint < 0xDC00 && next >= 0xDC00 && next < 0xE000) {
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (next - 0xDC00);
+                ++i;
+            } else {
+                codePoint = 0xFFFD;
+            }
+        }
+        if (codePoint < 0x80) {
+            text += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            text += static_cast<char>(0xC0 | (codePoint >> 6));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            text += static_cast<char>(0xE0 | (codePoint >> 12));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            text += static_cast<char>(0xF0 | (codePoint >> 18));
+            text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+    return text;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// ------------------------------ UTF-8 <-> wchar_t (UTF-16 on Windows, UTF-32 elsewhere) ------------------------------ //
+// Config text (font names, fuel names, currency symbols, IPs) arrives as UTF-8 and the SDK, the console and the
+// font code want wide strings. Runs of ASCII are widened 16 bytes at a time with SSE2 where available; everything
+// else goes through a validating decoder (RFC 3629: no overlong forms, surrogates or code points above U+10FFFF).
+
+// ---------- Strict, into a caller-owned buffer whose capacity is reused; throws std::runtime_error("invalid UTF-8 at byte N") ---------- //
+void utf8ToWide(const char* data, size_t size, std::wstring& out);
+
+inline void utf8ToWide(const std::string& text, std::wstring& out) {
+    utf8ToWide(text.data(), text.size(), out);
+}
+
+inline std::wstring utf8ToWide(const std::string& text) {
+    std::wstring out;
+    utf8ToWide(text, out);
+    return out;
+}
+
+// ---------- Lenient, for log lines and error messages: malformed bytes become U+FFFD, never throws ---------- //
+std::wstring widen(const std::string& text);
+
+// ---------- Wide back to UTF-8 (unpaired UTF-16 surrogates become U+FFFD) ---------- //
+std::string wideToUtf8(const std::wstring& wide);
@@ -59,7 +59,8 @@ export function setupDataHandelers(
 
   ipcMainOn("sendDataToScreen", async (fuelItems) => {
     saveFuelItems(fuelItems);
-    const output = await sendDataToScreen(fuelItems, config);
+    // A manual send always reaches the signs, even if they already show these prices
+    const output = await sendDataToScreen(fuelItems, config, { force: true });
     dialog.showMessageBoxSync({
       type: "info",
       title: "C++ Output",
@@ -11,7 +11,10 @@ import {
   setIsRegularUpdateEnabled,
 } from "./services/dataService.js";
 import { isUpdateSchedulerActive } from "./services/regularUpdateService.js";
-import { sendDataToScreen } from "./services/screenService.js";
+import {
+  sendDataToScreen,
+  stopWrapperDaemon,
+} from "./services/screenService.js";
 
 app.on("ready", async () => {
   // ------------------------------ Check what flag the exe has been called with ------------------------------ //
@@ -104,3 +107,7 @@ app.on("ready", async () => {
 app.on("window-all-closed", () => {
   app.quit();
 });
+
+app.on("will-quit", () => {
+  stopWrapperDaemon();
+});
@@ -101,11 +101,20 @@ export async function readConfigFromDirectory(
   }
 }
 
+// "13, 14" -> [13, 14]
+function parseCodeList(value: string): number[] {
+  return value
+    .split(",")
+    .map((code) => parseInt(code.trim(), 10))
+    .filter((code) => !isNaN(code));
+}
+
 function parseIniContent(content: string): Config {
   const config: Config = {};
   const lines = content.split("\n");
 
   const fuelNames: string[] = [];
+  const displays = new Map<number, DisplayTarget>();
 
   for (const line of lines) {
     const trimmedLine = line.trim();
@@ -151,6 +160,9 @@ function parseIniContent(content: string): Config {
       case "AdjustTime":
         config.adjustTime = value;
         break;
+      case "TimeSyncTimeoutMs":
+        config.timeSyncTimeoutMs = parseInt(value, 10);
+        break;
       case "ScreenWidth":
         config.screenWidth = parseInt(value, 10);
         break;
@@ -175,10 +187,76 @@ function parseIniContent(content: string): Config {
       case "DecimalFontHeight":
         config.decimalFontHeight = parseInt(value, 10);
         break;
+      case "AutoFitFont":
+        config.autoFitFont = value;
+        break;
+      case "PriceDecimals":
+        config.priceDecimals = parseInt(value, 10);
+        break;
+      case "DecimalSeparator":
+        config.decimalSeparator = value;
+        break;
+      case "GroupSeparator":
+        config.groupSeparator = value;
+        break;
+      case "CurrencySymbol":
+        config.currencySymbol = value;
+        break;
+      case "CurrencyBefore":
+        config.currencyBefore = value;
+        break;
+
+      // Cabinet grid of one sign side (see native-wrapper/screen_layout.hpp)
+      case "GridRows":
+        config.gridRows = parseInt(value, 10);
+        break;
+      case "GridColumns":
+        config.gridColumns = parseInt(value, 10);
+        break;
+      case "GridCellSizes":
+        config.gridCellSizes = value;
+        break;
+      case "GridGapX":
+        config.gridGapX = parseInt(value, 10);
+        break;
+      case "GridGapY":
+        config.gridGapY = parseInt(value, 10);
+        break;
+      case "GridCellItems":
+        config.gridCellItems = value;
+        break;
+      case "GridSecondSide":
+        config.gridSecondSide = value;
+        break;
+
+      case "MaxParallelDisplays":
+        config.maxParallelDisplays = parseInt(value, 10);
+        break;
+
+      case "RetryMaxAttempts":
+        config.retryMaxAttempts = parseInt(value, 10);
+        break;
+      case "RetryBaseDelayMs":
+        config.retryBaseDelayMs = parseInt(value, 10);
+        break;
+      case "RetryMaxDelayMs":
+        config.retryMaxDelayMs = parseInt(value, 10);
+        break;
+      case "RetryDeadlineMs":
+        config.retryDeadlineMs = parseInt(value, 10);
+        break;
+      case "RetryableErrorCodes":
+        config.retryableErrorCodes = parseCodeList(value);
+        break;
+      case "ConfigurationErrorCodes":
+        config.configurationErrorCodes = parseCodeList(value);
+        break;
 
       default:
         if (cleanKey.startsWith("Fuel") && cleanKey.endsWith("Name")) {
           fuelNames.push(value);
+        } else {
+          parseDisplayKey(cleanKey, value, displays);
         }
         break;
     }
@@ -188,9 +266,100 @@ function parseIniContent(content: string): Config {
     config.fuelNames = fuelNames;
   }
 
+  if (displays.size > 0) {
+    config.displays = [...displays.entries()]
+      .sort(([a], [b]) => a - b)
+      .map(([, display]) => display);
+  }
+
   return config;
 }
 
+// Extra displays: Display2IPAddress, Display2ScreenWidth, Display2CardType, ...
+function parseDisplayKey(
+  key: string,
+  value: string,
+  displays: Map<number, DisplayTarget>
+) {
+  const match = key.match(
+    /^Display(\d+)(IPAddress|ScreenWidth|ScreenHeight|CardType|RowColumn|DoubleSided|FontName|FontHeight|DecimalFontHeight|AutoFitFont|PriceDecimals|DecimalSeparator|GroupSeparator|CurrencySymbol|CurrencyBefore|GridRows|GridColumns|GridCellSizes|GridGapX|GridGapY|GridCellItems|GridSecondSide)$/
+  );
+  if (!match) return;
+
+  const displayNumber = parseInt(match[1], 10);
+  const display = displays.get(displayNumber) ?? {};
+  displays.set(displayNumber, display);
+
+  switch (match[2]) {
+    case "IPAddress":
+      display.displayIpAddress = value;
+      break;
+    case "ScreenWidth":
+      display.screenWidth = parseInt(value, 10);
+      break;
+    case "ScreenHeight":
+      display.screenHeight = parseInt(value, 10);
+      break;
+    case "CardType":
+      display.cardType = value;
+      break;
+    case "RowColumn":
+      display.rowColumn = value;
+      break;
+    case "DoubleSided":
+      display.doubleSided = value;
+      break;
+    case "FontName":
+      display.fontName = value;
+      break;
+    case "FontHeight":
+      display.fontHeight = parseInt(value, 10);
+      break;
+    case "DecimalFontHeight":
+      display.decimalFontHeight = parseInt(value, 10);
+      break;
+    case "AutoFitFont":
+      display.autoFitFont = value;
+      break;
+    case "PriceDecimals":
+      display.priceDecimals = parseInt(value, 10);
+      break;
+    case "DecimalSeparator":
+      display.decimalSeparator = value;
+      break;
+    case "GroupSeparator":
+      display.groupSeparator = value;
+      break;
+    case "CurrencySymbol":
+      display.currencySymbol = value;
+      break;
+    case "CurrencyBefore":
+      display.currencyBefore = value;
+      break;
+    case "GridRows":
+      display.gridRows = parseInt(value, 10);
+      break;
+    case "GridColumns":
+      display.gridColumns = parseInt(value, 10);
+      break;
+    case "GridCellSizes":
+      display.gridCellSizes = value;
+      break;
+    case "GridGapX":
+      display.gridGapX = parseInt(value, 10);
+      break;
+    case "GridGapY":
+      display.gridGapY = parseInt(value, 10);
+      break;
+    case "GridCellItems":
+      display.gridCellItems = value;
+      break;
+    case "GridSecondSide":
+      display.gridSecondSide = value;
+      break;
+  }
+}
+
 export function getLogoBase64(
   directoryPath: string | null,
   logoFileName: string | undefined
@@ -1,112 +1,248 @@
-import { spawn } from "child_process";
+import { ChildProcessWithoutNullStreams, spawn } from "child_process";
 import path from "path";
 import { fileURLToPath } from "url";
 import { app } from "electron";
+import { encodeMessagePackFrame } from "../utils/msgpack.js";
 
-function sendPayloadToWrapper(jsonPayload: string): Promise<string> {
-  return new Promise((resolve, reject) => {
-    const isProduction = app.isPackaged;
-    let wrapperPath;
-
-    if (isProduction) {
-      // In production, the executable is in the 'resources' folder next to the app's executable.
-      // process.resourcesPath correctly points to this folder.
-      wrapperPath = path.join(
-        process.resourcesPath,
-        "native-wrapper/dll_wrapper.exe"
-      );
-    } else {
-      // In development, use the relative path from your source code structure.
-      const __filename = fileURLToPath(import.meta.url);
-      const __dirname = path.dirname(__filename);
-      wrapperPath = path.join(
-        __dirname,
-        "../../native-wrapper/dll_wrapper.exe"
+// ------------------------------ Persistent wrapper process (--daemon) ------------------------------ //
+// The wrapper keeps HDSdk.dll loaded between sends, so every push after the first one skips
+// process startup and SDK initialization. Its stdout carries nothing but result records, one
+// UTF-8 JSON line per command and answered strictly in order; the human-readable log arrives
+// on stderr. Commands start out as JSON lines; once the ready record lists "msgpack", they
+// switch to length-prefixed MessagePack frames.
+
+type PendingSend = {
+  output: string;
+  resolve: (output: string) => void;
+  reject: (error: Error) => void;
+};
+
+let wrapperProcess: ChildProcessWithoutNullStreams | null = null;
+let pendingSends: PendingSend[] = [];
+let resultLineBuffer = "";
+let logLineBuffer = "";
+let wrapperInputFormat: "json" | "msgpack" = "json";
+
+const isWindows = process.platform === "win32";
+
+function getWrapperPath(): string {
+  const isProduction = app.isPackaged;
+
+  console.log(
+    `Running in ${isProduction ? "production" : "development"} mode.`
+  );
+
+  // Windows uses the MSVC build next to HDSdk.dll, Linux the native CMake build
+  const wrapperName = isWindows ? "dll_wrapper.exe" : "dll_wrapper";
+
+  if (isProduction) {
+    // In production, the executable is in the 'resources' folder next to the app's executable.
+    // process.resourcesPath correctly points to this folder.
+    return path.join(process.resourcesPath, "native-wrapper", wrapperName);
+  }
+
+  // In development, use the relative path from your source code structure.
+  const __filename = fileURLToPath(import.meta.url);
+  const __dirname = path.dirname(__filename);
+  return path.join(__dirname, "../../native-wrapper", wrapperName);
+}
+
+function writeWrapperCommand(
+  childProcess: ChildProcessWithoutNullStreams,
+  command: object
+) {
+  if (wrapperInputFormat === "msgpack") {
+    childProcess.stdin.write(encodeMessagePackFrame(command));
+  } else {
+    childProcess.stdin.write(JSON.stringify(command) + "\n");
+  }
+}
+
+// Ready record: {"ready": true, "inputFormat": "json", "inputFormats": ["json", "msgpack"]}
+function negotiateInputFormat(
+  childProcess: ChildProcessWithoutNullStreams,
+  ready: WrapperResult
+) {
+  if (!ready.inputFormats?.includes("msgpack")) {
+    return;
+  }
+
+  // The switch is answered like any other command; everything written after it is framed
+  pendingSends.push({
+    output: "",
+    resolve: (output) => console.log("Wrapper input format:", output.trim()),
+    reject: () => {},
+  });
+  writeWrapperCommand(childProcess, { command: "setFormat", format: "msgpack" });
+  wrapperInputFormat = "msgpack";
+}
+
+// Log lines belong to the command being processed; before the first one they are the startup banner
+function handleLogLine(line: string) {
+  const pending = pendingSends[0];
+  if (pending) {
+    pending.output += line + "\n";
+  } else {
+    console.log(line);
+  }
+}
+
+function handleResultLine(
+  childProcess: ChildProcessWithoutNullStreams,
+  line: string
+) {
+  if (!line) {
+    return;
+  }
+
+  let result: WrapperResult;
+  try {
+    result = JSON.parse(line);
+  } catch (parseError) {
+    console.error("Failed to parse wrapper result:", parseError, line);
+    pendingSends.shift()?.reject(
+      new Error("Failed to parse wrapper result record: " + line)
+    );
+    return;
+  }
+
+  if (result.ready) {
+    negotiateInputFormat(childProcess, result);
+    return;
+  }
+
+  const pending = pendingSends.shift();
+  if (!pending) {
+    console.log("Unexpected wrapper result:", line);
+    return;
+  }
+
+  console.log("=== WRAPPER LOG ===");
+  console.log(pending.output);
+  console.log("=== END WRAPPER LOG ===");
+
+  if (result.success) {
+    console.log("✅ Wrapper success:", result.message);
+  } else {
+    console.error(
+      "❌ Wrapper error:",
+      result.error,
+      "Details:",
+      result.details || "N/A"
+    );
+    console.error("Full result object:", JSON.stringify(result, null, 2));
+  }
+  pending.resolve(pending.output + line + "\n");
+}
+
+// Splits a stream into lines, keeping the unfinished tail in the returned buffer
+function forEachLine(
+  buffer: string,
+  data: string,
+  onLine: (line: string) => void
+): string {
+  const lines = (buffer + data).split("\n");
+  const rest = lines.pop() ?? "";
+  for (const line of lines) {
+    onLine(line.replace(/\r$/, ""));
+  }
+  return rest;
+}
+
+function startWrapperDaemon(): ChildProcessWithoutNullStreams {
+  const wrapperPath = getWrapperPath();
+  console.log(`Attempting to spawn wrapper daemon at: ${wrapperPath}`);
+
+  // Controller health (dead signs are skipped instead of waiting for the SDK timeout) is kept across app restarts
+  const healthCachePath = path.join(
+    app.getPath("userData"),
+    "jsonData",
+    "controller-health.json"
+  );
+
+  // The last phases and SDK calls before a crash survive the process (decode with flight_recorder_tool)
+  const flightRecorderPath = path.join(
+    app.getPath("userData"),
+    "jsonData",
+    "flight-recorder.bin"
+  );
+
+  const childProcess = spawn(wrapperPath, [
+    "--daemon",
+    `--health-cache=${healthCachePath}`,
+    `--flight-recorder=${flightRecorderPath}`,
+  ]);
+  let errorOutput = "";
+  wrapperInputFormat = "json";
+
+  // Result records are UTF-8 everywhere; the log is UTF-16 console text on Windows
+  childProcess.stdout.setEncoding("utf8");
+  childProcess.stderr.setEncoding(isWindows ? "utf16le" : "utf8");
+
+  childProcess.stdout.on("data", (data: string) => {
+    resultLineBuffer = forEachLine(resultLineBuffer, data, (line) =>
+      handleResultLine(childProcess, line)
+    );
+  });
+
+  childProcess.stderr.on("data", (data: string) => {
+    // The tail of the log explains an unexpected exit
+    errorOutput = (errorOutput + data).slice(-8192);
+    logLineBuffer = forEachLine(logLineBuffer, data, handleLogLine);
+  });
+
+  childProcess.on("close", (code) => {
+    if (wrapperProcess === childProcess) {
+      wrapperProcess = null;
+      resultLineBuffer = "";
+      logLineBuffer = "";
+    }
+
+    const unanswered = pendingSends;
+    pendingSends = [];
+    for (const pending of unanswered) {
+      pending.reject(
+        new Error(
+          `Wrapper process exited with code ${code}. \nOutput: ${pending.output} \nError: ${errorOutput}`
+        )
       );
     }
+  });
 
-    console.log(
-      `Running in ${isProduction ? "production" : "development"} mode.`
-    );
-    console.log(`Attempting to spawn wrapper at: ${wrapperPath}`);
-
-    console.log("Spawning wrapper with payload...");
-
-    const childProcess = spawn(wrapperPath);
-    let output = "";
-    let errorOutput = "";
-
-    // Set encodings for reading stdout (UTF-16) and stderr (standard)
-    childProcess.stdout.setEncoding("utf16le");
-    childProcess.stderr.setEncoding("utf8");
-
-    childProcess.stdout.on("data", (data) => {
-      output += data;
-    });
-
-    childProcess.stderr.on("data", (data) => {
-      errorOutput += data;
-    });
-
-    childProcess.on("close", (code) => {
-      if (code !== 0) {
-        reject(
-          new Error(
-            `Wrapper process exited with code ${code}. \nOutput: ${output} \nError: ${errorOutput}`
-          )
-        );
-        return;
-      }
-      try {
-        // Log the full raw output for debugging
-        console.log("=== WRAPPER FULL OUTPUT ===");
-        console.log(output);
-        console.log("=== END WRAPPER OUTPUT ===");
-
-        const jsonResponses = output
-          .trim()
-          .split("\n")
-          .filter((s) => s.startsWith("{"));
-        const lastResponse = jsonResponses[jsonResponses.length - 1];
-
-        console.log("Last JSON response:", lastResponse);
-        const result = JSON.parse(lastResponse);
-
-        if (result.success) {
-          console.log("✅ Wrapper success:", result.message);
-          resolve(output);
-        } else {
-          console.error(
-            "❌ Wrapper error:",
-            result.error,
-            "Details:",
-            result.details || "N/A"
-          );
-          console.error("Full result object:", JSON.stringify(result, null, 2));
-          resolve(output);
-        }
-      } catch (parseError) {
-        console.error("Failed to parse wrapper output:", parseError);
-        reject(
-          new Error(
-            "Failed to parse wrapper JSON output. Raw output: " + output
-          )
-        );
-      }
-    });
-
-    childProcess.on("error", (err) => {
-      reject(err);
-    });
-
-    childProcess.stdin.write(jsonPayload + "\n");
-    childProcess.stdin.end();
+  childProcess.on("error", (err) => {
+    console.error("Wrapper process error:", err);
   });
+
+  return childProcess;
+}
+
+function sendPayloadToWrapper(payload: object): Promise<string> {
+  return new Promise((resolve, reject) => {
+    if (!wrapperProcess) {
+      wrapperProcess = startWrapperDaemon();
+    }
+
+    console.log(`Sending payload to wrapper daemon (${wrapperInputFormat})...`);
+
+    pendingSends.push({ output: "", resolve, reject });
+    writeWrapperCommand(wrapperProcess, payload);
+  });
+}
+
+export function stopWrapperDaemon() {
+  if (!wrapperProcess) {
+    return;
+  }
+
+  writeWrapperCommand(wrapperProcess, { command: "shutdown" });
+  wrapperProcess.stdin.end();
+  wrapperProcess = null;
 }
 
 export async function sendDataToScreen(
   fuelItems: FuelItem[],
-  config: Config
+  config: Config,
+  options: { force?: boolean } = {}
 ): Promise<string> {
   if (!config.displayIpAddress) {
     console.error("❌ No displayIpAddress provided in config.");
@@ -116,12 +252,16 @@ export async function sendDataToScreen(
   const payload = {
     config: config,
     fuelItems: fuelItems,
+    // Extra signs are built and sent concurrently by the wrapper
+    displays: (config.displays ?? []).filter(
+      (display) => display.displayIpAddress
+    ),
+    // Without force the wrapper skips signs that already show this exact content
+    force: options.force ?? false,
   };
 
-  const jsonPayload = JSON.stringify(payload);
-
   try {
-    const output = await sendPayloadToWrapper(jsonPayload);
+    const output = await sendPayloadToWrapper(payload);
     return output;
   } catch (error) {
     console.error("Error calling screen sender:", error);
@@ -0,0 +1,161 @@
+// ------------------------------ MessagePack encoder for wrapper commands ------------------------------ //
+// Covers what JSON.stringify would send: null, booleans, numbers, strings, arrays and plain objects.
+// Keys with undefined values are skipped like in JSON. Integers use the smallest int/uint form,
+// other numbers go out as float64 (the wrapper reads prices back as their shortest decimal).
+
+class ByteWriter {
+  private buffer = Buffer.allocUnsafe(1024);
+  length = 0;
+
+  private reserve(bytes: number) {
+    if (this.length + bytes <= this.buffer.length) {
+      return;
+    }
+    const grown = Buffer.allocUnsafe(
+      Math.max(this.buffer.length * 2, this.length + bytes)
+    );
+    this.buffer.copy(grown, 0, 0, this.length);
+    this.buffer = grown;
+  }
+
+  byte(value: number) {
+    this.reserve(1);
+    this.buffer[this.length++] = value;
+  }
+
+  uint16(value: number) {
+    this.reserve(2);
+    this.length = this.buffer.writeUInt16BE(value, this.length);
+  }
+
+  uint32(value: number) {
+    this.reserve(4);
+    this.length = this.buffer.writeUInt32BE(value, this.length);
+  }
+
+  int32(value: number) {
+    this.reserve(4);
+    this.length = this.buffer.writeInt32BE(value, this.length);
+  }
+
+  int64(value: number) {
+    this.reserve(8);
+    this.length = this.buffer.writeBigInt64BE(BigInt(value), this.length);
+  }
+
+  float64(value: number) {
+    this.reserve(8);
+    this.length = this.buffer.writeDoubleBE(value, this.length);
+  }
+
+  text(value: string, byteLength: number) {
+    this.reserve(byteLength);
+    this.length += this.buffer.write(value, this.length, "utf8");
+  }
+
+  bytes(): Buffer {
+    return this.buffer.subarray(0, this.length);
+  }
+}
+
+function writeInteger(out: ByteWriter, value: number) {
+  if (value >= 0) {
+    if (value < 0x80) {
+      out.byte(value);
+    } else if (value <= 0xff) {
+      out.byte(0xcc);
+      out.byte(value);
+    } else if (value <= 0xffff) {
+      out.byte(0xcd);
+      out.uint16(value);
+    } else if (value <= 0xffffffff) {
+      out.byte(0xce);
+      out.uint32(value);
+    } else {
+      out.byte(0xd3);
+      out.int64(value);
+    }
+  } else if (value >= -32) {
+    out.byte(value & 0xff);
+  } else if (value >= -0x80000000) {
+    out.byte(0xd2);
+    out.int32(value);
+  } else {
+    out.byte(0xd3);
+    out.int64(value);
+  }
+}
+
+function writeString(out: ByteWriter, value: string) {
+  const byteLength = Buffer.byteLength(value, "utf8");
+  if (byteLength < 32) {
+    out.byte(0xa0 | byteLength);
+  } else if (byteLength <= 0xff) {
+    out.byte(0xd9);
+    out.byte(byteLength);
+  } else if (byteLength <= 0xffff) {
+    out.byte(0xda);
+    out.uint16(byteLength);
+  } else {
+    out.byte(0xdb);
+    out.uint32(byteLength);
+  }
+  out.text(value, byteLength);
+}
+
+function writeHeader(out: ByteWriter, count: number, fix: number, marker16: number) {
+  if (count < 16) {
+    out.byte(fix | count);
+  } else if (count <= 0xffff) {
+    out.byte(marker16);
+    out.uint16(count);
+  } else {
+    out.byte(marker16 + 1);
+    out.uint32(count);
+  }
+}
+
+function writeValue(out: ByteWriter, value: unknown) {
+  if (value === null || value === undefined) {
+    out.byte(0xc0);
+  } else if (typeof value === "boolean") {
+    out.byte(value ? 0xc3 : 0xc2);
+  } else if (typeof value === "number") {
+    if (!Number.isFinite(value)) {
+      out.byte(0xc0); // JSON.stringify sends NaN / Infinity as null
+    } else if (Number.isSafeInteger(value)) {
+      writeInteger(out, value);
+    } else {
+      out.byte(0xcb);
+      out.float64(value);
+    }
+  } else if (typeof value === "string") {
+    writeString(out, value);
+  } else if (Array.isArray(value)) {
+    writeHeader(out, value.length, 0x90, 0xdc);
+    for (const element of value) {
+      writeValue(out, element);
+    }
+  } else if (typeof value === "object") {
+    const entries = Object.entries(value as Record<string, unknown>).filter(
+      ([, entry]) => entry !== undefined && typeof entry !== "function"
+    );
+    writeHeader(out, entries.length, 0x80, 0xde);
+    for (const [key, entry] of entries) {
+      writeString(out, key);
+      writeValue(out, entry);
+    }
+  } else {
+    out.byte(0xc0);
+  }
+}
+
+// ------------------------------ One wrapper frame: u32 little-endian byte count + MessagePack body ------------------------------ //
+export function encodeMessagePackFrame(value: unknown): Buffer {
+  const out = new ByteWriter();
+  out.uint32(0); // length placeholder
+  writeValue(out, value);
+  const frame = out.bytes();
+  frame.writeUInt32LE(frame.length - 4, 0);
+  return frame;
+}
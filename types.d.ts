@@ -5,6 +5,7 @@ type Config = {
   fuelNames?: string[];
   timeDisplayIpAddress?: string;
   adjustTime?: string;
+  timeSyncTimeoutMs?: number;
 
   screenWidth?: number;
   screenHeight?: number;
@@ -14,6 +15,60 @@ type Config = {
   fontName?: string;
   fontHeight?: number;
   decimalFontHeight?: number;
+  autoFitFont?: string; // "Y" = largest font heights that fit the module, FontHeight/DecimalFontHeight only set the ratio
+
+  // Price text: "1.234,56 ден" style formatting (see native-wrapper/price_format.hpp)
+  priceDecimals?: number; // 2 or 3
+  decimalSeparator?: string;
+  groupSeparator?: string;
+  currencySymbol?: string;
+  currencyBefore?: string; // "Y" = symbol before the number
+
+  // Cabinet grid of one sign side; GridRows/GridColumns unset = one row/column (RowColumn) of ScreenWidth x ScreenHeight modules
+  gridRows?: number;
+  gridColumns?: number;
+  gridCellSizes?: string; // "128x64,96x64,..." row-major
+  gridGapX?: number;
+  gridGapY?: number;
+  gridCellItems?: string; // "1,2,0,3" fuel per cell, 0 = blank
+  gridSecondSide?: string; // "R" | "B"
+
+  displays?: DisplayTarget[];
+  maxParallelDisplays?: number;
+
+  // Retries of Hd_SendScreen / Cmd_AdjustTime (see native-wrapper/retry_policy.hpp)
+  retryMaxAttempts?: number;
+  retryBaseDelayMs?: number;
+  retryMaxDelayMs?: number;
+  retryDeadlineMs?: number;
+  retryableErrorCodes?: number[];
+  configurationErrorCodes?: number[];
+};
+
+// Extra sign showing the same fuel list; unset fields fall back to the main display's values
+type DisplayTarget = {
+  displayIpAddress?: string;
+  screenWidth?: number;
+  screenHeight?: number;
+  cardType?: string;
+  rowColumn?: string;
+  doubleSided?: string;
+  fontName?: string;
+  fontHeight?: number;
+  decimalFontHeight?: number;
+  autoFitFont?: string;
+  priceDecimals?: number;
+  decimalSeparator?: string;
+  groupSeparator?: string;
+  currencySymbol?: string;
+  currencyBefore?: string;
+  gridRows?: number;
+  gridColumns?: number;
+  gridCellSizes?: string;
+  gridGapX?: number;
+  gridGapY?: number;
+  gridCellItems?: string;
+  gridSecondSide?: string;
 };
 
 type FuelItem = {
@@ -22,6 +77,60 @@ type FuelItem = {
   price: number;
 };
 
+// ------------------------------ Result record of the native wrapper (one UTF-8 JSON line on its stdout) ------------------------------ //
+type WrapperSdkCall = {
+  call: string; // "Hd_CreateScreen", "Hd_AddArea", "Hd_SendScreen", "Cmd_AdjustTime", ...
+  area?: number;
+  success: boolean;
+  errorCode?: number;
+  durationUs: number;
+};
+
+type WrapperDisplayResult = {
+  displayIpAddress: string;
+  success: boolean;
+  errorCode: number;
+  durationMs: number;
+  attempts: number;
+  attemptMs?: number[];
+  errorCategory?: string;
+  contentHash?: string;
+  unchanged?: boolean;
+  skipped?: boolean;
+  error?: string;
+  areas?: {
+    areaId: number;
+    x: number;
+    y: number;
+    width: number;
+    height: number;
+    itemIds: number[];
+  }[];
+  sdkCalls?: WrapperSdkCall[];
+};
+
+type WrapperResult = {
+  success: boolean;
+  message?: string;
+  error?: string;
+  details?: string;
+  sendScreen?: boolean;
+  adjustTime?: boolean;
+  displays?: WrapperDisplayResult[];
+  timeSync?: {
+    success: boolean;
+    errorCode: number;
+    attempts: number;
+    skipped?: boolean;
+    sdkCalls?: WrapperSdkCall[];
+  };
+  durationMs?: number;
+  // Daemon ready record
+  ready?: boolean;
+  inputFormat?: string;
+  inputFormats?: string[];
+};
+
 type ConfigPathData = {
   configPath: string;
 };